@@ -10,15 +10,32 @@
 #include "ppu.h"
 #include "ui.h"
 #include "dma.h"
+#ifdef CPU_AOT
+#include "cpu_aot.h"
+#endif
+#ifdef CPU_STATS
+#include "cpu_stats.h"
+#endif
+#ifdef CPU_TRACE
+#include "cpu_trace.h"
+#include <cstdlib>
+#endif
 #include <iostream>
 
 int main(int argc, char** argv) {
 
     // ensure that user provides a rom file
+#ifdef CPU_AOT
+    if (argc != 2 && argc != 3) {
+        std::cout << "Usage: " << argv[0] << " <rom> [aot module]" << std::endl;
+        return 1;
+    }
+#else
     if (argc != 2) {
         std::cout << "Usage: " << argv[0] << " <rom>" << std::endl;
         return 1;
     }
+#endif
 
     // get the path
     const char* path = argv[1];
@@ -36,6 +53,25 @@ int main(int argc, char** argv) {
     ppu_init();
     ui_init();
 
+#ifdef CPU_AOT
+    // recompiled code is optional; without it everything is interpreted
+    if (argc == 3) {
+        cpu_aot_load(argv[2]);
+    }
+#endif
+
+#ifdef CPU_TRACE
+    // binary instruction trace, convert with tools/trace2txt
+    if (const char *trace_path = std::getenv("GBEMU_TRACE")) {
+        cpu_trace_start(trace_path);
+    }
+#endif
+
+#ifdef CPU_STATS
+    // opcode statistics, printed at exit or on SIGUSR1
+    cpu_stats_init();
+#endif
+
     // initialize the emulator context
     // and set the default values
     emu_context *ctx = emu_get_context();
@@ -47,7 +83,6 @@ int main(int argc, char** argv) {
     static const uint32_t CYCLES_PER_FRAME = 70224;
     uint32_t frame_cycles = 0;
 
-    uint8_t cycles = 0;
     while (ctx->running && !ctx->die) {
         // handle events
         ui_handle_events();
@@ -58,23 +93,26 @@ int main(int argc, char** argv) {
             continue;
         }
 
-        // run cpu step
-        cycles = cpu_step();
-
-        // advance emulator cycles
-        emu_cycles(cycles);
-
-        // advance ppu
-        ppu_step(cycles);
+        // run the cpu (and the scheduled timer/dma/ppu events) up to the end of the frame
+        frame_cycles += cpu_run(CYCLES_PER_FRAME - frame_cycles);
 
         // update ui once per frame
-        frame_cycles += cycles;
         if (frame_cycles >= CYCLES_PER_FRAME) {
             frame_cycles -= CYCLES_PER_FRAME;
-            ui_handle_events();
+            ppu_sync();  // draw the lines the PPU has not caught up on yet
             ui_update();
+#ifdef CPU_STATS
+            cpu_stats_poll();
+#endif
         }
     }
 
+#ifdef CPU_TRACE
+    cpu_trace_stop();
+#endif
+#ifdef CPU_STATS
+    cpu_stats_dump(stderr);
+#endif
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "cpu_dispatch.h"
+#include <cstdint>
+
+// Longest straight-line run predecoded into one block.
+constexpr uint8_t BLOCK_MAX_INSTRS = 32;
+
+// Bank key used for blocks that live in WRAM/HRAM instead of ROM.
+constexpr uint16_t BLOCK_RAM_BANK = 0xFFFF;
+
+struct block_instr;
+
+// Runs the instruction at `in` (at pc) and the one after it as a pair; see
+// cpu_fusion.h. Returns the cycles run.
+typedef uint32_t (*fused_handler)(const block_instr *in, uint16_t pc, uint32_t budget);
+
+typedef struct block_instr {
+    const op_entry *entry;  // handler + pre-decoded operands
+    uint8_t bytes[3];       // raw instruction bytes (opcode or CB prefix first)
+#ifdef CPU_FUSION
+    fused_handler fused;    // set on the first instruction of a fused pair
+#endif
+} block_instr;
+
+typedef struct {
+    uint16_t pc;
+    uint16_t bank;          // cart_rom_bank() of pc, or BLOCK_RAM_BANK
+    uint32_t generation;    // RAM blocks are only valid for the generation they were built in
+    uint8_t count;          // 0 means pc is not cacheable (e.g. an instruction crosses a bank edge)
+    bool valid;
+    block_instr instrs[BLOCK_MAX_INSTRS];
+} cpu_block;
+
+// Bumped whenever cached code may no longer match memory (bank switch or a
+// write over cached RAM code); a running block stops when it changes.
+extern uint32_t block_cache_epoch;
+
+// Set while a cached instruction runs so fetch8/fetch16 read its immediates
+// from the block instead of going through bus_read.
+extern const uint8_t *block_fetch_ptr;
+
+void block_cache_init();
+
+// Block starting at pc under the current bank mapping, built on a miss.
+// Returns nullptr when pc is outside ROM/WRAM/HRAM.
+const cpu_block *block_cache_lookup(uint16_t pc);
+
+// bus_write hook: ROM writes are MBC register writes, WRAM/HRAM writes may
+// hit cached code.
+void block_cache_write(uint16_t addr);
+
+// block_cache_write for every address in [addr, addr + count).
+void block_cache_write_range(uint16_t addr, uint16_t count);
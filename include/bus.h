@@ -1,8 +1,62 @@
 #pragma once
+#ifdef CPU_BLOCK_CACHE
+#include "block_cache.h"
+#endif
 #include <cstdint>
 
-uint8_t bus_read(uint16_t address);
-void bus_write(uint16_t address, uint8_t value);
+typedef uint8_t (*page_read_fn)(uint16_t address);
+typedef void (*page_write_fn)(uint16_t address, uint8_t value);
+
+// One entry per 256-byte page. Plain memory (mapped ROM banks, VRAM, WRAM,
+// echo RAM, enabled cart RAM) is a host pointer to the page; everything else
+// (MBC registers, disabled/RTC cart RAM, OAM, IO, HRAM/IE) goes through the
+// page's handler. VRAM writes also take the handler so the PPU can catch up
+// first.
+typedef struct {
+    const uint8_t *read[256];
+    uint8_t *write[256];
+    page_read_fn read_handler[256];
+    page_write_fn write_handler[256];
+} bus_page_table;
+
+extern bus_page_table bus_pages;
+
+// Inline so instruction fetch and the load/store handlers compile down to a
+// table load and a branch for plain memory.
+inline uint8_t bus_read(uint16_t address) {
+    const uint8_t *mem = bus_pages.read[address >> 8];
+    if (mem) {
+        return mem[address & 0xFF];
+    }
+    return bus_pages.read_handler[address >> 8](address);
+}
+
+inline void bus_write(uint16_t address, uint8_t value) {
+#ifdef CPU_BLOCK_CACHE
+    block_cache_write(address);
+#endif
+
+    uint8_t *mem = bus_pages.write[address >> 8];
+    if (mem) {
+        mem[address & 0xFF] = value;
+        return;
+    }
+    bus_pages.write_handler[address >> 8](address, value);
+}
+
+// Refresh the page table entries for ROM and cart RAM from cart_page(). The
+// cart calls this after loading and after every MBC register write.
+void bus_map_cart();
+
+// Point every page but 0xFF at handlers that read 0xFF and drop writes for
+// the length of an OAM DMA transfer, and restore the normal table after.
+void bus_dma_lock(bool locked);
 
 uint16_t bus_read16(uint16_t address);
-void bus_write16(uint16_t address, uint16_t value);
\ No newline at end of file
+void bus_write16(uint16_t address, uint16_t value);
+
+// Block transfers: same result as `count` single-byte bus_read/bus_write
+// pairs in ascending address order, but plain RAM (and ROM or cart RAM
+// sources) is copied directly.
+void bus_copy(uint16_t dst, uint16_t src, uint16_t count);
+void bus_fill(uint16_t dst, uint8_t value, uint16_t count);
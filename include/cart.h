@@ -20,5 +20,16 @@ typedef struct {
 
 bool cart_load(const char *cart);
 
+// Header of the loaded cart.
+const rom_header *cart_header();
+
 uint8_t cart_read(uint16_t address);
-void cart_write(uint16_t address, uint8_t value);
\ No newline at end of file
+void cart_write(uint16_t address, uint8_t value);
+
+// Host memory backing the 256-byte page at `address` (ROM or cart RAM) under
+// the current mapping, or nullptr when accesses there need cart_read/
+// cart_write (open bus, disabled RAM, RTC registers, short ROM images).
+uint8_t *cart_page(uint16_t address);
+
+// ROM bank currently mapped at a 0x0000-0x7FFF address (used to key cached code).
+uint16_t cart_rom_bank(uint16_t address);
@@ -1,8 +1,34 @@
 #pragma once
+#include "cpu_alu.h"
 #include <cstdint>
 
+// One register pair: the two 8-bit halves laid out so the pair is also a
+// native 16-bit word.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define CPU_REG_PAIR(hi, lo) struct { uint8_t hi, lo; }
+#else
+#define CPU_REG_PAIR(hi, lo) struct { uint8_t lo, hi; }
+#endif
+
+// Slots in cpu_state::r16 and cpu_state::r8.
+enum : uint8_t { R16_AF, R16_BC, R16_DE, R16_HL };
+
 struct cpu_state {
-    uint8_t A, F, B, C, D, E, H, L;
+    // AF, BC, DE and HL are each one word whose halves are the 8-bit
+    // registers, so 16-bit reads/writes are single loads/stores. r16/r8 view
+    // the same storage by index (see cpu_reg8_slot for the byte order).
+    // Go through cpu_flags()/read_reg16 for F and AF: with lazy flags the
+    // stored F may be stale.
+    union {
+        struct {
+            union { CPU_REG_PAIR(A, F); uint16_t AF; };
+            union { CPU_REG_PAIR(B, C); uint16_t BC; };
+            union { CPU_REG_PAIR(D, E); uint16_t DE; };
+            union { CPU_REG_PAIR(H, L); uint16_t HL; };
+        };
+        uint16_t r16[4];
+        uint8_t r8[8];
+    };
     uint16_t PC, SP;
     bool ime, halt, stop;
     bool enabling_ime;  // EI delays IME enabling by one instruction
@@ -17,14 +43,122 @@ struct cpu_state {
     // PC of the current instruction being executed (captured at start of instruction)
     // Used for accurate logging in bus_write and other memory operations
     uint16_t last_opcode_pc;
+#ifdef CPU_LAZY_FLAGS
+    // Lazy flags: F holds the bits already known, flag_mask the Z/H/C bits
+    // still to be derived from the last ALU op's operands and result.
+    uint8_t flag_mask;
+    uint8_t flag_a, flag_b;
+    uint16_t flag_res;  // bit 8 is the carry/borrow out
+#endif
 };
 
 extern cpu_state cpu;
 
-constexpr uint8_t FLAG_Z = 0x80; // Zero
-constexpr uint8_t FLAG_N = 0x40; // Subtract
-constexpr uint8_t FLAG_H = 0x20; // Half-carry
-constexpr uint8_t FLAG_C = 0x10; // Carry
+// r8 index of the high (hi = true) or low byte of r16 slot `pair`.
+constexpr uint8_t cpu_reg8_slot(uint8_t pair, bool hi) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return static_cast<uint8_t>(pair * 2 + (hi ? 0 : 1));
+#else
+    return static_cast<uint8_t>(pair * 2 + (hi ? 1 : 0));
+#endif
+}
+
+// Flag access. All reads and writes of F go through these so that with
+// CPU_LAZY_FLAGS the ALU only records its operands and F is built on demand
+// (conditional jumps, PUSH AF, ADC/SBC, DAA, trace output).
+//
+// The ALU recorders take the 9-bit result (carry/borrow out in bit 8); H is
+// always the carry into bit 4, i.e. bit 4 of a ^ b ^ result.
+#ifdef CPU_LAZY_FLAGS
+
+inline uint8_t cpu_flags() {
+    if (cpu.flag_mask) {
+        cpu.F |= alu_zhc(cpu.flag_a, cpu.flag_b, cpu.flag_res) & cpu.flag_mask;
+        cpu.flag_mask = 0;
+    }
+    return cpu.F;
+}
+
+inline void cpu_set_flags(uint8_t f) {
+    cpu.F = f;
+    cpu.flag_mask = 0;
+}
+
+inline bool cpu_flag_z() {
+    return (cpu.flag_mask & FLAG_Z) ? (cpu.flag_res & 0xFF) == 0 : (cpu.F & FLAG_Z) != 0;
+}
+
+inline bool cpu_flag_c() {
+    return (cpu.flag_mask & FLAG_C) ? (cpu.flag_res & 0x100) != 0 : (cpu.F & FLAG_C) != 0;
+}
+
+inline void cpu_flags_record(uint8_t known, uint8_t mask, uint8_t a, uint8_t b, uint16_t res) {
+    cpu.F = known;
+    cpu.flag_mask = mask;
+    cpu.flag_a = a;
+    cpu.flag_b = b;
+    cpu.flag_res = res;
+}
+
+inline void cpu_flags_add(uint8_t a, uint8_t b, uint16_t res) {
+    cpu_flags_record(0, FLAG_Z | FLAG_H | FLAG_C, a, b, res);
+}
+
+inline void cpu_flags_sub(uint8_t a, uint8_t b, uint16_t res) {
+    cpu_flags_record(FLAG_N, FLAG_Z | FLAG_H | FLAG_C, a, b, res);
+}
+
+// INC/DEC keep C, which may itself still be pending.
+inline void cpu_flags_inc(uint8_t a, uint8_t res) {
+    cpu_flags_record(cpu_flag_c() ? FLAG_C : 0, FLAG_Z | FLAG_H, a, 1, res);
+}
+
+inline void cpu_flags_dec(uint8_t a, uint8_t res) {
+    cpu_flags_record(FLAG_N | (cpu_flag_c() ? FLAG_C : 0), FLAG_Z | FLAG_H, a, 1, res);
+}
+
+// AND/OR/XOR: only Z depends on the result; H is 1 for AND, 0 otherwise.
+inline void cpu_flags_logic(uint8_t res, uint8_t h) {
+    cpu_flags_record(h, FLAG_Z, 0, 0, res);
+}
+
+#else
+
+inline uint8_t cpu_flags() { return cpu.F; }
+inline void cpu_set_flags(uint8_t f) { cpu.F = f; }
+inline bool cpu_flag_z() { return (cpu.F & FLAG_Z) != 0; }
+inline bool cpu_flag_c() { return (cpu.F & FLAG_C) != 0; }
+
+inline void cpu_flags_add(uint8_t a, uint8_t b, uint16_t res) {
+    cpu.F = alu_zhc(a, b, res);
+}
+
+inline void cpu_flags_sub(uint8_t a, uint8_t b, uint16_t res) {
+    cpu.F = alu_zhc(a, b, res) | FLAG_N;
+}
+
+inline void cpu_flags_inc(uint8_t a, uint8_t) {
+    cpu.F = (cpu.F & FLAG_C) | alu_inc(a);
+}
+
+inline void cpu_flags_dec(uint8_t a, uint8_t) {
+    cpu.F = (cpu.F & FLAG_C) | alu_dec(a);
+}
+
+inline void cpu_flags_logic(uint8_t res, uint8_t h) {
+    cpu.F = h | (res == 0 ? FLAG_Z : 0);
+}
+
+#endif
 
 void cpu_init();
-uint8_t cpu_step();
\ No newline at end of file
+uint8_t cpu_step();
+
+// First part of cpu_step (EI delay, interrupt entry, HALT) for cores that
+// fetch and dispatch on their own. Returns the cycles of a step that ran no
+// instruction, or 0 when an instruction should run next.
+uint8_t cpu_step_begin();
+
+// Run whole instructions, ticking timer/DMA/PPU after each, until at least
+// `cycles` T-cycles have elapsed. Returns the cycles actually run.
+uint32_t cpu_run(uint32_t cycles);
\ No newline at end of file
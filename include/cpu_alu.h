@@ -0,0 +1,125 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// Flag results of the 8-bit ALU, independent of cpu_state. Each result has
+// an arithmetic form (alu_calc_*) and a lookup-table form (alu_table_*);
+// alu_* picks one at build time (`make ALU_TABLES=1` for the tables).
+// lib/cpu_alu.cpp checks every table entry against the arithmetic.
+
+constexpr uint8_t FLAG_Z = 0x80; // Zero
+constexpr uint8_t FLAG_N = 0x40; // Subtract
+constexpr uint8_t FLAG_H = 0x20; // Half-carry
+constexpr uint8_t FLAG_C = 0x10; // Carry
+
+// ---- arithmetic ----
+
+// Z, H and C of an add/sub/compare whose 9-bit result (carry/borrow out in
+// bit 8) is `res`; H is the carry into bit 4, i.e. bit 4 of a ^ b ^ res.
+constexpr uint8_t alu_calc_zhc(uint8_t a, uint8_t b, uint16_t res) {
+    return ((res & 0xFF) == 0 ? FLAG_Z : 0)
+         | (((a ^ b ^ res) & 0x10) ? FLAG_H : 0)
+         | ((res & 0x100) ? FLAG_C : 0);
+}
+
+// Z and H of INC a (N clear, C untouched).
+constexpr uint8_t alu_calc_inc(uint8_t a) {
+    uint8_t res = static_cast<uint8_t>(a + 1);
+    return (res == 0 ? FLAG_Z : 0) | (((a ^ 1 ^ res) & 0x10) ? FLAG_H : 0);
+}
+
+// N, Z and H of DEC a (C untouched).
+constexpr uint8_t alu_calc_dec(uint8_t a) {
+    uint8_t res = static_cast<uint8_t>(a - 1);
+    return FLAG_N | (res == 0 ? FLAG_Z : 0) | (((a ^ 1 ^ res) & 0x10) ? FLAG_H : 0);
+}
+
+// DAA of a with flags f: (new A << 8) | new F.
+constexpr uint16_t alu_calc_daa(uint8_t a, uint8_t f) {
+    uint8_t correction = 0;
+    bool carry_out = false;
+
+    const bool n = (f & FLAG_N) != 0;
+    const bool h = (f & FLAG_H) != 0;
+    const bool c = (f & FLAG_C) != 0;
+
+    if (!n) {
+        if (h || (a & 0x0F) > 9) {
+            correction |= 0x06;
+        }
+        if (c || a > 0x99) {
+            correction |= 0x60;
+            carry_out = true;
+        }
+        a = static_cast<uint8_t>(a + correction);
+    } else {
+        if (h) correction |= 0x06;
+        if (c) correction |= 0x60;
+        a = static_cast<uint8_t>(a - correction);
+        carry_out = c;
+    }
+
+    f &= FLAG_N;
+    if (a == 0) f |= FLAG_Z;
+    if (carry_out) f |= FLAG_C;
+    return static_cast<uint16_t>((a << 8) | f);
+}
+
+// ---- tables ----
+
+// Z and C by 9-bit result.
+inline constexpr std::array<uint8_t, 512> kAluZC = [] {
+    std::array<uint8_t, 512> t{};
+    for (unsigned res = 0; res < 512; res++) {
+        t[res] = alu_calc_zhc(0, 0, static_cast<uint16_t>(res)) & (FLAG_Z | FLAG_C);
+    }
+    return t;
+}();
+
+inline constexpr std::array<uint8_t, 256> kAluInc = [] {
+    std::array<uint8_t, 256> t{};
+    for (unsigned a = 0; a < 256; a++) t[a] = alu_calc_inc(static_cast<uint8_t>(a));
+    return t;
+}();
+
+inline constexpr std::array<uint8_t, 256> kAluDec = [] {
+    std::array<uint8_t, 256> t{};
+    for (unsigned a = 0; a < 256; a++) t[a] = alu_calc_dec(static_cast<uint8_t>(a));
+    return t;
+}();
+
+// DAA indexed by A | N/H/C << 8 (the only input flags DAA looks at).
+constexpr unsigned alu_daa_index(uint8_t a, uint8_t f) {
+    return a | (((f >> 4) & 7u) << 8);
+}
+
+inline constexpr std::array<uint16_t, 2048> kAluDaa = [] {
+    std::array<uint16_t, 2048> t{};
+    for (unsigned i = 0; i < 2048; i++) {
+        t[i] = alu_calc_daa(static_cast<uint8_t>(i), static_cast<uint8_t>((i >> 8) << 4));
+    }
+    return t;
+}();
+
+constexpr uint8_t alu_table_zhc(uint8_t a, uint8_t b, uint16_t res) {
+    // Bit 4 of a ^ b ^ res shifted up is FLAG_H.
+    return static_cast<uint8_t>(kAluZC[res & 0x1FF] | (((a ^ b ^ res) & 0x10) << 1));
+}
+
+constexpr uint8_t alu_table_inc(uint8_t a) { return kAluInc[a]; }
+constexpr uint8_t alu_table_dec(uint8_t a) { return kAluDec[a]; }
+constexpr uint16_t alu_table_daa(uint8_t a, uint8_t f) { return kAluDaa[alu_daa_index(a, f)]; }
+
+// ---- build-time choice ----
+
+#ifdef CPU_ALU_TABLES
+constexpr uint8_t alu_zhc(uint8_t a, uint8_t b, uint16_t res) { return alu_table_zhc(a, b, res); }
+constexpr uint8_t alu_inc(uint8_t a) { return alu_table_inc(a); }
+constexpr uint8_t alu_dec(uint8_t a) { return alu_table_dec(a); }
+constexpr uint16_t alu_daa(uint8_t a, uint8_t f) { return alu_table_daa(a, f); }
+#else
+constexpr uint8_t alu_zhc(uint8_t a, uint8_t b, uint16_t res) { return alu_calc_zhc(a, b, res); }
+constexpr uint8_t alu_inc(uint8_t a) { return alu_calc_inc(a); }
+constexpr uint8_t alu_dec(uint8_t a) { return alu_calc_dec(a); }
+constexpr uint16_t alu_daa(uint8_t a, uint8_t f) { return alu_calc_daa(a, f); }
+#endif
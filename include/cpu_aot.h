@@ -0,0 +1,97 @@
+#pragma once
+
+#include "cpu.h"
+#include "block_cache.h"
+#include "emu.h"
+#include <cstdint>
+
+// Ahead-of-time recompiled ROM code. tools/gbrecomp.cpp walks a ROM's control
+// flow and writes one C++ function per (bank, pc) block; the result is built
+// into a shared object that cpu_aot_load() plugs into cpu_run.
+
+// Bumped whenever the layout below, cpu_state or the generated code's
+// contract changes.
+constexpr uint32_t AOT_MODULE_VERSION = 4;
+
+// Build settings compiled into the generated code: the flag representation,
+// the ALU flavour and the cpu_state layout. A module only runs in a gbemu
+// built with the same ones.
+constexpr uint32_t aot_build_fingerprint() {
+    uint32_t settings = 0;
+#ifdef CPU_LAZY_FLAGS
+    settings |= 1;
+#endif
+#ifdef CPU_ALU_TABLES
+    settings |= 2;
+#endif
+    return settings | static_cast<uint32_t>(sizeof(cpu_state)) << 8;
+}
+
+// A compiled block runs until it ends, control leaves it or `budget`
+// T-cycles are used, and returns the cycles run.
+typedef uint32_t (*aot_block_fn)(uint32_t budget);
+
+typedef struct {
+    uint16_t bank;   // cart_rom_bank() of pc when the block was compiled
+    uint16_t pc;
+    aot_block_fn fn;
+} aot_block;
+
+// Exported by a generated module as `gb_aot_module`. The header fields are
+// checked against the loaded cart so a module only runs on its own ROM, and
+// `build` against this gbemu's build settings.
+typedef struct {
+    uint32_t version;
+    uint32_t build;          // aot_build_fingerprint() of the module
+    uint8_t title[16];
+    uint8_t type;
+    uint8_t rom_size;
+    uint8_t checksum;
+    uint32_t count;
+    const aot_block *blocks;
+} aot_module;
+
+// Load a module built for the current cart. Returns false (and leaves the
+// interpreter in charge) if it cannot be opened or does not match.
+bool cpu_aot_load(const char *path);
+
+// Generated code for pc under the current bank mapping, or nullptr.
+aot_block_fn cpu_aot_lookup(uint16_t pc);
+
+// Helpers used by generated code. Each compiled instruction does the same
+// bookkeeping as cpu_run_block (minus the trace log) so timing matches the
+// interpreter exactly.
+
+inline uint32_t aot_tick(uint32_t elapsed, uint8_t step) {
+    emu_cycles(step);
+    return elapsed + step;
+}
+
+inline void aot_begin_instruction(uint16_t pc) {
+    cpu.instr_count++;
+    cpu.last_opcode_pc = pc;
+}
+
+inline void aot_end_instruction() {
+    if (cpu.enabling_ime) {
+        cpu.enabling_ime = false;
+        cpu.ime_pending = true;
+    }
+}
+
+// One instruction at `pc` with opcode OP (CB opcodes are CB_OPCODE_BASE | op)
+// whose immediates are `imm`; `next` is where straight-line flow continues.
+#define AOT_INSTR(pc, next, prefix, OP, imm)                                   \
+    do {                                                                       \
+        uint8_t step = cpu_step_begin();                                       \
+        if (step) return aot_tick(elapsed, step);                              \
+        aot_begin_instruction(pc);                                             \
+        cpu.PC = static_cast<uint16_t>((pc) + (prefix));                       \
+        block_fetch_ptr = (imm);                                               \
+        step = specialized::execute<OP>();                                     \
+        block_fetch_ptr = nullptr;                                             \
+        aot_end_instruction();                                                 \
+        elapsed = aot_tick(elapsed, step);                                     \
+        if (elapsed >= budget || cpu.PC != (next) || block_cache_epoch != epoch) \
+            return elapsed;                                                    \
+    } while (0)
@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+
+// Copy/fill loop recognition. Call right after a backward jump, like
+// cpu_idle_skip. When the loop at cpu.PC is one of the known byte copy or
+// fill shapes (e.g. LD A,(HL+) / LD (DE),A / INC DE / DEC BC / LD A,B /
+// OR C / JR NZ), its remaining trips up to the next timer/PPU event are done
+// with one bus_copy/bus_fill, with HL/DE/BC/A/F and the clock left exactly
+// where the interpreter would leave them. Returns the T-cycles run (0 when
+// nothing was done), always below `budget`.
+uint32_t cpu_bulk_skip(uint32_t budget);
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "cpu_instructions.h"
+#include <array>
+#include <cstdint>
+
+// Every opcode handler shares this signature so it can live in one table.
+typedef uint8_t (*op_handler)(const Instruction&);
+
+// A fully resolved opcode: the handler to call and its pre-decoded operands.
+struct op_entry {
+    op_handler handler;
+    Instruction inst;
+    uint8_t length;  // bytes including any CB prefix and immediates
+};
+
+// 0x000-0x0FF are the base opcodes, 0x100-0x1FF the CB-prefixed opcodes.
+constexpr uint16_t CB_OPCODE_BASE = 0x100;
+
+extern std::array<op_entry, 512> dispatch_table;
+
+// Decode all 512 opcodes once so cpu_step never has to call decode().
+void cpu_dispatch_init();
+
+// Swap in the compile-time specialized handlers from cpu_specialized.cpp.
+void cpu_dispatch_specialize();
@@ -0,0 +1,13 @@
+#pragma once
+#include "block_cache.h"
+#include <cstdint>
+
+// Superinstructions for the block cache (`make FUSION=1`). Frequent adjacent
+// opcode pairs (e.g. LD A,(HL+) / LD (DE),A, DEC B / JR NZ, LDH A,(n) / CP n)
+// get one handler that runs both with a single dispatch. Each half is still
+// ticked, traced and checked for interrupts on its own, so timing and cycle
+// totals are the same as running them separately.
+
+// Handler for `first` followed by `second` (dispatch_table indices), or
+// nullptr when the pair is not fused.
+fused_handler cpu_fusion_lookup(uint16_t first, uint16_t second);
@@ -0,0 +1,10 @@
+#pragma once
+#include <cstdint>
+
+// Busy-wait loop detection. Call right after a backward jump (cpu.PC at or
+// below cpu.last_opcode_pc). When the loop at cpu.PC is a short read-only
+// poll (e.g. LDH A,(44) / CP n / JR NZ) whose last trip left every register
+// unchanged, the remaining trips are identical until the timer or PPU next
+// changes something, so they are run as one clock advance. Returns the
+// T-cycles skipped (0 when nothing was skipped), always below `budget`.
+uint32_t cpu_idle_skip(uint32_t budget);
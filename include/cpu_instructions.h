@@ -110,3 +110,6 @@ struct Instruction {
 // Decode a single opcode into a high-level Instruction
 Instruction decode(uint8_t opcode, bool is_cb = false);
 
+// Encoded size in bytes, including the CB prefix and any immediates.
+uint8_t instruction_length(const Instruction &inst, bool is_cb = false);
+
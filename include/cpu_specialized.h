@@ -0,0 +1,358 @@
+#pragma once
+
+#include "cpu_dispatch.h"
+#include "cpu_utils.h"
+#include "cpu.h"
+#include "bus.h"
+#include "stack.h"
+#include <cstdint>
+
+// Handlers in this file are generated per opcode from templates, so register
+// selection, addressing mode and condition are all resolved at compile time.
+// They must stay flag- and cycle-identical to the generic execute_* handlers
+// in cpu_proc.cpp, which remain in the table for every opcode not covered here.
+namespace specialized {
+
+// Operand ids as encoded in the opcode bits: B, C, D, E, H, L, (HL), A.
+constexpr uint8_t OPERAND_HL = 6;
+
+// Register pair ids as encoded in the opcode bits: BC, DE, HL, SP (or AF for PUSH/POP).
+constexpr uint8_t PAIR_HL = 2;
+
+// Condition ids as encoded in the opcode bits, plus "always".
+constexpr uint8_t COND_NZ = 0;
+constexpr uint8_t COND_Z = 1;
+constexpr uint8_t COND_NC = 2;
+constexpr uint8_t COND_C = 3;
+constexpr uint8_t COND_ALWAYS = 4;
+
+template <uint8_t R>
+inline uint8_t &reg8() {
+    static_assert(R != OPERAND_HL && R < 8, "not an 8-bit register");
+    if constexpr (R == 0) return cpu.B;
+    else if constexpr (R == 1) return cpu.C;
+    else if constexpr (R == 2) return cpu.D;
+    else if constexpr (R == 3) return cpu.E;
+    else if constexpr (R == 4) return cpu.H;
+    else if constexpr (R == 5) return cpu.L;
+    else return cpu.A;
+}
+
+inline uint16_t hl() {
+    return cpu.HL;
+}
+
+template <uint8_t R>
+inline uint8_t read_operand() {
+    if constexpr (R == OPERAND_HL) return bus_read(hl());
+    else return reg8<R>();
+}
+
+template <uint8_t R>
+inline void write_operand(uint8_t v) {
+    if constexpr (R == OPERAND_HL) bus_write(hl(), v);
+    else reg8<R>() = v;
+}
+
+template <uint8_t P, bool AF = false>
+inline uint16_t read_pair() {
+    if constexpr (P == 0) return cpu.BC;
+    else if constexpr (P == 1) return cpu.DE;
+    else if constexpr (P == PAIR_HL) return hl();
+    else if constexpr (AF) return static_cast<uint16_t>((cpu.A << 8) | (cpu_flags() & 0xF0));
+    else return cpu.SP;
+}
+
+template <uint8_t P, bool AF = false>
+inline void write_pair(uint16_t v) {
+    if constexpr (P == 0) cpu.BC = v;
+    else if constexpr (P == 1) cpu.DE = v;
+    else if constexpr (P == PAIR_HL) cpu.HL = v;
+    else if constexpr (AF) { cpu.A = static_cast<uint8_t>(v >> 8); cpu_set_flags(v & 0xF0); }
+    else cpu.SP = v;
+}
+
+template <uint8_t CC>
+inline bool condition() {
+    if constexpr (CC == COND_NZ) return !cpu_flag_z();
+    else if constexpr (CC == COND_Z) return cpu_flag_z();
+    else if constexpr (CC == COND_NC) return !cpu_flag_c();
+    else if constexpr (CC == COND_C) return cpu_flag_c();
+    else return true;
+}
+
+// 8-bit ALU op ids as encoded in the opcode bits: ADD ADC SUB SBC AND XOR OR CP.
+template <uint8_t OP>
+inline void alu(uint8_t src) {
+    uint8_t a = cpu.A;
+    if constexpr (OP == 0 || OP == 1) {
+        uint8_t carry_in = (OP == 1 && cpu_flag_c()) ? 1 : 0;
+        uint16_t result = static_cast<uint16_t>(a + src + carry_in);
+        cpu.A = static_cast<uint8_t>(result);
+        cpu_flags_add(a, src, result);
+    } else if constexpr (OP == 2 || OP == 3 || OP == 7) {
+        int carry_in = (OP == 3 && cpu_flag_c()) ? 1 : 0;
+        uint16_t result = static_cast<uint16_t>(a - src - carry_in);
+        if constexpr (OP != 7) cpu.A = static_cast<uint8_t>(result);
+        cpu_flags_sub(a, src, result);
+    } else if constexpr (OP == 4) {
+        cpu.A = a & src;
+        cpu_flags_logic(cpu.A, FLAG_H);
+    } else if constexpr (OP == 5) {
+        cpu.A = a ^ src;
+        cpu_flags_logic(cpu.A, 0);
+    } else {
+        cpu.A = a | src;
+        cpu_flags_logic(cpu.A, 0);
+    }
+}
+
+// ---- 8-bit loads ----
+
+template <uint8_t DST, uint8_t SRC>
+inline uint8_t ld_r_r(const Instruction&) {
+    write_operand<DST>(read_operand<SRC>());
+    return (DST == OPERAND_HL || SRC == OPERAND_HL) ? 8 : 4;
+}
+
+template <uint8_t DST>
+inline uint8_t ld_r_n(const Instruction&) {
+    if constexpr (DST == OPERAND_HL) {
+        uint16_t addr = hl();
+        bus_write(addr, fetch8());
+        return 12;
+    } else {
+        reg8<DST>() = fetch8();
+        return 8;
+    }
+}
+
+// ---- 8-bit arithmetic ----
+
+template <uint8_t OP, uint8_t SRC>
+inline uint8_t alu_a_r(const Instruction&) {
+    alu<OP>(read_operand<SRC>());
+    return SRC == OPERAND_HL ? 8 : 4;
+}
+
+template <uint8_t OP>
+inline uint8_t alu_a_n(const Instruction&) {
+    alu<OP>(fetch8());
+    return 8;
+}
+
+template <uint8_t R>
+inline uint8_t inc_r(const Instruction&) {
+    uint8_t value = read_operand<R>();
+    uint8_t result = static_cast<uint8_t>(value + 1);
+    write_operand<R>(result);
+    cpu_flags_inc(value, result);
+    return R == OPERAND_HL ? 12 : 4;
+}
+
+template <uint8_t R>
+inline uint8_t dec_r(const Instruction&) {
+    uint8_t value = read_operand<R>();
+    uint8_t result = static_cast<uint8_t>(value - 1);
+    write_operand<R>(result);
+    cpu_flags_dec(value, result);
+    return R == OPERAND_HL ? 12 : 4;
+}
+
+// ---- 16-bit loads and arithmetic ----
+
+template <uint8_t P>
+inline uint8_t ld_rr_nn(const Instruction&) {
+    write_pair<P>(fetch16());
+    return 12;
+}
+
+template <uint8_t P>
+inline uint8_t inc_rr(const Instruction&) {
+    write_pair<P>(static_cast<uint16_t>(read_pair<P>() + 1));
+    return 8;
+}
+
+template <uint8_t P>
+inline uint8_t dec_rr(const Instruction&) {
+    write_pair<P>(static_cast<uint16_t>(read_pair<P>() - 1));
+    return 8;
+}
+
+template <uint8_t P>
+inline uint8_t add_hl_rr(const Instruction&) {
+    uint16_t a = hl();
+    uint16_t b = read_pair<P>();
+    uint32_t result = static_cast<uint32_t>(a) + b;
+    write_pair<PAIR_HL>(static_cast<uint16_t>(result));
+    uint8_t f = cpu_flag_z() ? FLAG_Z : 0;
+    if (((a & 0x0FFF) + (b & 0x0FFF)) > 0x0FFF) f |= FLAG_H;
+    if (result > 0xFFFF) f |= FLAG_C;
+    cpu_set_flags(f);
+    return 8;
+}
+
+template <uint8_t P>
+inline uint8_t push_rr(const Instruction&) {
+    stack_push16(read_pair<P, true>());
+    return 16;
+}
+
+template <uint8_t P>
+inline uint8_t pop_rr(const Instruction&) {
+    write_pair<P, true>(stack_pop16());
+    return 12;
+}
+
+// ---- Control flow ----
+
+template <uint8_t CC>
+inline uint8_t jr(const Instruction&) {
+    int8_t offset = static_cast<int8_t>(fetch8());
+    if (condition<CC>()) {
+        cpu.PC = static_cast<uint16_t>(cpu.PC + offset);
+        return 12;
+    }
+    return 8;
+}
+
+template <uint8_t CC>
+inline uint8_t jp(const Instruction&) {
+    uint16_t addr = fetch16();
+    if (condition<CC>()) {
+        cpu.PC = addr;
+        return 16;
+    }
+    return 12;
+}
+
+template <uint8_t CC>
+inline uint8_t call(const Instruction&) {
+    uint16_t addr = fetch16();
+    if (condition<CC>()) {
+        cpu.SP = static_cast<uint16_t>(cpu.SP - 2);
+        bus_write16(cpu.SP, cpu.PC);
+        cpu.PC = addr;
+        return 24;
+    }
+    return 12;
+}
+
+template <uint8_t CC>
+inline uint8_t ret(const Instruction&) {
+    if (condition<CC>()) {
+        cpu.PC = bus_read16(cpu.SP);
+        cpu.SP = static_cast<uint16_t>(cpu.SP + 2);
+        return CC == COND_ALWAYS ? 16 : 20;
+    }
+    return 8;
+}
+
+template <uint8_t VEC>
+inline uint8_t rst(const Instruction&) {
+    cpu.SP = static_cast<uint16_t>(cpu.SP - 2);
+    bus_write16(cpu.SP, cpu.PC);
+    cpu.PC = VEC;
+    return 16;
+}
+
+// ---- CB prefix ----
+
+// Rotate/shift op ids as encoded in the opcode bits: RLC RRC RL RR SLA SRA SWAP SRL.
+template <uint8_t OP, uint8_t R>
+inline uint8_t cb_shift(const Instruction&) {
+    uint8_t v = read_operand<R>();
+    uint8_t result;
+    uint8_t carry;
+    if constexpr (OP == 0) { carry = v >> 7; result = static_cast<uint8_t>((v << 1) | carry); }
+    else if constexpr (OP == 1) { carry = v & 1; result = static_cast<uint8_t>((v >> 1) | (carry << 7)); }
+    else if constexpr (OP == 2) { carry = v >> 7; result = static_cast<uint8_t>((v << 1) | (cpu_flag_c() ? 1 : 0)); }
+    else if constexpr (OP == 3) { carry = v & 1; result = static_cast<uint8_t>((v >> 1) | (cpu_flag_c() ? 0x80 : 0)); }
+    else if constexpr (OP == 4) { carry = v >> 7; result = static_cast<uint8_t>(v << 1); }
+    else if constexpr (OP == 5) { carry = v & 1; result = static_cast<uint8_t>((v >> 1) | (v & 0x80)); }
+    else if constexpr (OP == 6) { carry = 0; result = static_cast<uint8_t>((v << 4) | (v >> 4)); }
+    else { carry = v & 1; result = static_cast<uint8_t>(v >> 1); }
+    write_operand<R>(result);
+    cpu_set_flags((result == 0 ? FLAG_Z : 0) | (carry ? FLAG_C : 0));
+    return R == OPERAND_HL ? 16 : 8;
+}
+
+template <uint8_t BIT, uint8_t R>
+inline uint8_t cb_bit(const Instruction&) {
+    uint8_t v = read_operand<R>();
+    uint8_t f = (cpu_flag_c() ? FLAG_C : 0) | FLAG_H;
+    if (!(v & (1u << BIT))) f |= FLAG_Z;
+    cpu_set_flags(f);
+    return R == OPERAND_HL ? 12 : 8;
+}
+
+template <uint8_t BIT, uint8_t R>
+inline uint8_t cb_res(const Instruction&) {
+    write_operand<R>(static_cast<uint8_t>(read_operand<R>() & ~(1u << BIT)));
+    return R == OPERAND_HL ? 16 : 8;
+}
+
+template <uint8_t BIT, uint8_t R>
+inline uint8_t cb_set(const Instruction&) {
+    write_operand<R>(static_cast<uint8_t>(read_operand<R>() | (1u << BIT)));
+    return R == OPERAND_HL ? 16 : 8;
+}
+
+// Pick the specialized handler for an opcode, or nullptr to keep the generic one.
+template <uint16_t OP>
+constexpr op_handler handler() {
+    constexpr uint8_t x = (OP >> 6) & 0x03;
+    constexpr uint8_t y = (OP >> 3) & 0x07;
+    constexpr uint8_t z = OP & 0x07;
+    constexpr uint8_t p = y >> 1;
+
+    if constexpr (OP >= CB_OPCODE_BASE) {
+        if constexpr (x == 0) return cb_shift<y, z>;
+        else if constexpr (x == 1) return cb_bit<y, z>;
+        else if constexpr (x == 2) return cb_res<y, z>;
+        else return cb_set<y, z>;
+    } else if constexpr (x == 1) {
+        if constexpr (OP == 0x76) return nullptr;  // HALT
+        else return ld_r_r<y, z>;
+    } else if constexpr (x == 2) {
+        return alu_a_r<y, z>;
+    } else if constexpr (x == 0) {
+        if constexpr (z == 6) return ld_r_n<y>;
+        else if constexpr (z == 4) return inc_r<y>;
+        else if constexpr (z == 5) return dec_r<y>;
+        else if constexpr (z == 1 && !(y & 1)) return ld_rr_nn<p>;
+        else if constexpr (z == 1) return add_hl_rr<p>;
+        else if constexpr (z == 3 && !(y & 1)) return inc_rr<p>;
+        else if constexpr (z == 3) return dec_rr<p>;
+        else if constexpr (OP == 0x18) return jr<COND_ALWAYS>;
+        else if constexpr (z == 0 && y >= 4) return jr<y - 4>;
+        else return nullptr;
+    } else {
+        if constexpr (z == 0 && y < 4) return ret<y>;
+        else if constexpr (OP == 0xC9) return ret<COND_ALWAYS>;
+        else if constexpr (z == 2 && y < 4) return jp<y>;
+        else if constexpr (OP == 0xC3) return jp<COND_ALWAYS>;
+        else if constexpr (z == 4 && y < 4) return call<y>;
+        else if constexpr (OP == 0xCD) return call<COND_ALWAYS>;
+        else if constexpr (z == 1 && !(y & 1)) return pop_rr<p>;
+        else if constexpr (z == 5 && !(y & 1)) return push_rr<p>;
+        else if constexpr (z == 6) return alu_a_n<y>;
+        else if constexpr (z == 7) return rst<y * 8>;
+        else return nullptr;
+    }
+}
+
+// Run opcode OP: the specialized handler when there is one (so it can be
+// inlined into the caller), otherwise the generic handler from the table.
+template <uint16_t OP>
+inline uint8_t execute() {
+    constexpr op_handler specialized_handler = handler<OP>();
+    const op_entry &entry = dispatch_table[OP];
+    if constexpr (specialized_handler != nullptr) {
+        return specialized_handler(entry.inst);
+    } else {
+        return entry.handler(entry.inst);
+    }
+}
+
+} // namespace specialized
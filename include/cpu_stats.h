@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+
+// Execution statistics (build with `make STATS=1`): counts per opcode (base
+// and CB), per adjacent opcode pair and per addressing mode. The report goes
+// to stderr when the emulator exits, and on SIGUSR1 while it runs.
+// Instructions run by AOT code or skipped by the idle/bulk loop
+// shortcuts are not counted.
+
+#ifdef CPU_STATS
+
+// Install the SIGUSR1 handler.
+void cpu_stats_init();
+
+// Count one executed opcode (dispatch_table index, CB opcodes at CB_OPCODE_BASE).
+void cpu_stats_record(uint16_t op);
+
+// Print the report if SIGUSR1 arrived since the last call. Call from the main
+// loop; the signal handler itself only sets a flag.
+void cpu_stats_poll();
+
+// Sorted report of everything counted so far.
+void cpu_stats_dump(FILE *out);
+
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+
+// Binary instruction trace (build with `make TRACE=1`, run with
+// GBEMU_TRACE=<file>). The CPU only copies a fixed-size record into a ring
+// buffer; a background thread writes the buffer to disk, and tools/trace2txt
+// turns the file back into the old cpu_log.txt text format.
+
+constexpr char TRACE_MAGIC[8] = {'G', 'B', 'T', 'R', 'A', 'C', 'E', '1'};
+
+// Stop recording after this many instructions (same cap as the old text log).
+constexpr uint64_t TRACE_MAX_RECORDS = 100000;
+
+// One executed instruction: registers before it runs and the 4 bytes at PC.
+typedef struct {
+    uint8_t A, F, B, C, D, E, H, L;
+    uint16_t SP, PC;
+    uint8_t pcmem[4];
+} trace_record;
+
+static_assert(sizeof(trace_record) == 16, "trace records are written to disk as-is");
+
+#ifdef CPU_TRACE
+
+extern bool cpu_trace_enabled;
+
+// Start the writer thread and trace into `path`. Returns false if the file
+// cannot be created.
+bool cpu_trace_start(const char *path);
+
+// Drain the buffer, stop the writer thread and close the file.
+void cpu_trace_stop();
+
+// Record the instruction about to run at pc.
+void cpu_trace_record(uint16_t pc);
+
+#endif
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "cpu_instructions.h"
+#include "cpu.h"
+#include "bus.h"
+#ifdef CPU_BLOCK_CACHE
+#include "block_cache.h"
+#endif
 #include <cstdint>
 
 uint8_t read_reg8(reg_type r);
@@ -14,13 +19,29 @@ void     bus_write8(uint16_t addr, uint8_t v);
 uint16_t bus_read16(uint16_t addr);
 void     bus_write16(uint16_t addr, uint16_t v);
 
-uint8_t  fetch8();
-uint16_t fetch16();
+// Immediate bytes come from the running cached block when there is one.
+inline uint8_t fetch_byte() {
+#ifdef CPU_BLOCK_CACHE
+    if (block_fetch_ptr) {
+        return *block_fetch_ptr++;
+    }
+#endif
+    return bus_read(cpu.PC);
+}
 
-bool is_carry_add(uint8_t a, uint8_t b);
-bool is_half_carry_add(uint8_t a, uint8_t b);
-bool is_carry_sub(uint8_t a, uint8_t b);
-bool is_half_carry_sub(uint8_t a, uint8_t b);
+inline uint8_t fetch8() {
+    uint8_t value = fetch_byte();
+    cpu.PC = static_cast<uint16_t>(cpu.PC + 1);
+    return value;
+}
+
+inline uint16_t fetch16() {
+    uint8_t lo = fetch_byte();
+    cpu.PC = static_cast<uint16_t>(cpu.PC + 1);
+    uint8_t hi = fetch_byte();
+    cpu.PC = static_cast<uint16_t>(cpu.PC + 1);
+    return (static_cast<uint16_t>(hi) << 8) | static_cast<uint16_t>(lo);
+}
 
 // 16-bit variants used for operations like ADD HL,rr.
 bool is_carry_add16(uint16_t a, uint16_t b);
@@ -1,6 +1,10 @@
 #pragma once
 #include <cstdint>
 
+// OAM DMA copies page `start` to OAM as a single scheduled event at the end
+// of the transfer. Until then the CPU bus is locked down to the IO/HRAM page.
 void dma_start(uint8_t start);
-void dma_tick();
 bool dma_transferring();
+
+// Scheduler event (EV_DMA): the transfer is done.
+void dma_event();
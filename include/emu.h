@@ -1,14 +1,17 @@
 #pragma once
 #include <cstdint>
+#include "scheduler.h"
 
 typedef struct {
     bool paused;
     bool running;
     bool die;        // signal emulator should exit
-    uint64_t ticks;  // machine cycles (4 per cpu cycle)
 } emu_context;
 
 emu_context *emu_get_context();
 
-// advance cpu cycles
-void emu_cycles(int cpu_cycles);
\ No newline at end of file
+// advance the master clock by t_cycles, running any timer/DMA/PPU/serial
+// events that fall due
+inline void emu_cycles(int t_cycles) {
+    sched_advance(static_cast<uint32_t>(t_cycles));
+}
@@ -11,5 +11,11 @@ typedef enum {
     IT_JOYPAD = 16
 } interrupt_type;
 
+// IF & IE over the five interrupt bits. Everything that changes IF or IE
+// calls interrupt_flags_changed(), so "is anything pending" is one load.
+extern uint8_t interrupts_pending;
+
+void interrupt_flags_changed();
+
 uint8_t cpu_handle_interrupts(cpu_state *ctx);
-void request_interrupt(uint8_t type);
\ No newline at end of file
+void request_interrupt(uint8_t type);
@@ -17,6 +17,7 @@ typedef struct {
     uint8_t nr30, nr31, nr32, nr34;  // Channel 3
     uint8_t nr41, nr42, nr43, nr44;  // Channel 4
     uint8_t nr50, nr51, nr52;        // Sound control
+    uint8_t wave_ram[16];            // 0xFF30-0xFF3F
     
     // PPU registers
     uint8_t stat;       // LCD Status (0xFF41)
@@ -36,6 +37,9 @@ uint8_t io_read(uint16_t addr);
 void    io_write(uint16_t addr, uint8_t value);
 void io_init();
 
+// Scheduler event (EV_SERIAL): the transfer started by writing SC finished.
+void serial_event();
+
 // Joypad button indices
 enum joypad_btn {
     BTN_RIGHT  = 0,
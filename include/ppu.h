@@ -14,5 +14,31 @@ struct Sprite {
 extern uint32_t screen[160 * 144];
 
 void ppu_init();
-void ppu_step(uint8_t cycles);
-void ppu_oam_write(uint16_t address, uint8_t value);
\ No newline at end of file
+void ppu_oam_write(uint16_t address, uint8_t value);
+
+// The PPU only runs when something can see it: ppu_sync() brings it up to
+// sched.now and is called before every access to VRAM, OAM or a PPU
+// register. The scheduler only wakes it for VBlank and enabled STAT
+// interrupts.
+void ppu_sync();
+
+// Bring the PPU up to `when` (at most sched.now), leaving later mode and LY
+// changes pending.
+void ppu_sync_to(uint64_t when);
+
+// T-cycles until the next mode or LY change, capped at `limit`.
+uint32_t ppu_cycles_to_next_change(uint32_t limit);
+
+// VRAM bytes [index, index + count) changed. Tiles are kept decoded to
+// color indexes, and the ones covering tile data written here are decoded
+// again before they are next drawn.
+void ppu_vram_written(uint16_t index, uint16_t count);
+
+// LCDC, STAT and LYC writes go through here: they sync the PPU and reschedule
+// it (switching the LCD on or off, or changing the STAT interrupt sources).
+void ppu_lcdc_write(uint8_t value);
+void ppu_stat_write(uint8_t value);
+void ppu_lyc_write(uint8_t value);
+
+// Scheduler event (EV_PPU): a VBlank or STAT interrupt may be due.
+void ppu_event();
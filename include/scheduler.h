@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+
+// Central event scheduler. Components with time-dependent state register the
+// master-clock cycle of their next event; emu_cycles() advances the clock and
+// only calls into a component once its event is due, at the end of the step
+// it falls in (where the old per-step ticking would have seen it).
+
+typedef enum {
+    EV_TIMER,    // TIMA overflow
+    EV_DMA,      // OAM DMA transfer done
+    EV_PPU,      // PPU VBlank or STAT interrupt
+    EV_SERIAL,   // serial transfer complete
+    EV_COUNT
+} sched_event;
+
+constexpr uint64_t SCHED_NEVER = UINT64_MAX;
+
+typedef struct {
+    uint64_t now;             // master clock, T-cycles since power on
+    uint64_t next;            // earliest entry of `at`
+    uint64_t at[EV_COUNT];    // due time per event, SCHED_NEVER when idle
+} scheduler;
+
+extern scheduler sched;
+
+void sched_init();
+
+// Set (or move) an event; SCHED_NEVER cancels it.
+void sched_set(sched_event ev, uint64_t when);
+
+// Run every due event, in sched_event order. Handlers reschedule themselves.
+void sched_dispatch();
+
+inline void sched_advance(uint32_t cycles) {
+    sched.now += cycles;
+    if (sched.now >= sched.next) {
+        sched_dispatch();
+    }
+}
+
+// T-cycles from now to the earliest event (0 when one is already due),
+// capped at `limit`.
+inline uint32_t sched_cycles_to_next_event(uint32_t limit) {
+    if (sched.next <= sched.now) {
+        return 0;
+    }
+    uint64_t cycles = sched.next - sched.now;
+    return cycles < limit ? static_cast<uint32_t>(cycles) : limit;
+}
@@ -1,18 +1,23 @@
 #pragma once
 #include <cstdint>
 
+// DIV and TIMA are not ticked; they are worked out from the master clock
+// when read, and the scheduler is told the exact cycle TIMA next overflows.
 typedef struct {
-    uint16_t counter;
+    uint64_t div_base;   // sched.now when the 16-bit divider counter was last 0
+    uint64_t synced;     // sched.now TIMA has been brought up to
     uint8_t tima, tma, tac;
-    bool prev_and_result, interrupt_pending;
+    bool interrupt_pending;
 } timer_ctx;
 
 void timer_init();
-void timer_tick();
 uint8_t timer_read(uint16_t address);
 void timer_write(uint16_t address, uint8_t value);
 uint8_t get_div();
 void timer_write_div();
 void timer_write_tac(uint8_t value);
 void tima_increment();
-uint16_t get_system_bit_mask(uint8_t tac);
\ No newline at end of file
+uint16_t get_system_bit_mask(uint8_t tac);
+
+// Scheduler event (EV_TIMER): TIMA overflows on this step.
+void timer_event();
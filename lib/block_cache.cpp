@@ -0,0 +1,171 @@
+#include "block_cache.h"
+#include "cpu_dispatch.h"
+#include "cpu_instructions.h"
+#include "bus.h"
+#include "cart.h"
+#ifdef CPU_FUSION
+#include "cpu_fusion.h"
+#endif
+#include <cstdint>
+#include <cstring>
+
+// Direct-mapped on (pc, bank); a miss simply rebuilds the slot.
+static constexpr uint16_t BLOCK_CACHE_SIZE = 2048;
+static cpu_block blocks[BLOCK_CACHE_SIZE];
+
+// One flag per 64-byte chunk of WRAM (chunks 0-127) and HRAM (128-129) that
+// holds cached code, so ordinary data writes never touch the block table.
+static constexpr uint8_t RAM_CHUNK_SHIFT = 6;
+static uint8_t ram_code_chunks[(0x2000 + 0x80) >> RAM_CHUNK_SHIFT];
+static uint32_t ram_generation = 0;
+
+uint32_t block_cache_epoch = 0;
+const uint8_t *block_fetch_ptr = nullptr;
+
+static int ram_chunk(uint16_t addr) {
+    if (addr >= 0xC000 && addr < 0xE000) {
+        return (addr - 0xC000) >> RAM_CHUNK_SHIFT;
+    }
+    if (addr >= 0xFF80 && addr < 0xFFFF) {
+        return (0x2000 + addr - 0xFF80) >> RAM_CHUNK_SHIFT;
+    }
+    return -1;
+}
+
+// End (exclusive) of the region pc is in; a block never crosses it because
+// the memory past it may be mapped differently.
+static uint32_t region_end(uint16_t pc) {
+    if (pc < 0x4000) return 0x4000;
+    if (pc < 0x8000) return 0x8000;
+    if (pc < 0xE000) return 0xE000;
+    return 0xFFFF;
+}
+
+// Unconditional control flow and HALT/STOP; anything after them is not
+// reached in a straight line.
+static bool ends_block(const Instruction &inst) {
+    switch (inst.type) {
+        case in_type::IN_JP:
+        case in_type::IN_JR:
+        case in_type::IN_RET:
+            return inst.cond == cond_type::CT_NONE;
+        case in_type::IN_RETI:
+        case in_type::IN_RST:
+        case in_type::IN_HALT:
+        case in_type::IN_STOP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void build_block(cpu_block &block, uint16_t pc, uint16_t bank) {
+    block.pc = pc;
+    block.bank = bank;
+    block.generation = ram_generation;
+    block.count = 0;
+    block.valid = true;
+
+    uint32_t end = region_end(pc);
+    uint32_t addr = pc;
+    while (block.count < BLOCK_MAX_INSTRS && addr < end) {
+        uint16_t op = bus_read(static_cast<uint16_t>(addr));
+        if (op == 0xCB) {
+            if (addr + 1 >= end) break;
+            op = CB_OPCODE_BASE | bus_read(static_cast<uint16_t>(addr + 1));
+        }
+
+        const op_entry &entry = dispatch_table[op];
+        if (addr + entry.length > end) break;
+
+        block_instr &in = block.instrs[block.count++];
+        in.entry = &entry;
+        for (uint8_t i = 0; i < entry.length; i++) {
+            in.bytes[i] = bus_read(static_cast<uint16_t>(addr + i));
+        }
+        addr += entry.length;
+
+        if (ends_block(entry.inst)) break;
+    }
+
+#ifdef CPU_FUSION
+    // Pair up adjacent instructions left to right; a pair never overlaps the next.
+    for (uint8_t i = 0; i < block.count; i++) {
+        block.instrs[i].fused = nullptr;
+    }
+    for (uint8_t i = 0; i + 1 < block.count; i++) {
+        fused_handler fused = cpu_fusion_lookup(
+            static_cast<uint16_t>(block.instrs[i].entry - dispatch_table.data()),
+            static_cast<uint16_t>(block.instrs[i + 1].entry - dispatch_table.data()));
+        if (fused) {
+            block.instrs[i++].fused = fused;
+        }
+    }
+#endif
+
+    if (bank == BLOCK_RAM_BANK) {
+        for (uint32_t a = pc; a < addr; a += 1u << RAM_CHUNK_SHIFT) {
+            ram_code_chunks[ram_chunk(static_cast<uint16_t>(a))] = 1;
+        }
+        if (addr > pc) {
+            ram_code_chunks[ram_chunk(static_cast<uint16_t>(addr - 1))] = 1;
+        }
+    }
+}
+
+void block_cache_init() {
+    memset(blocks, 0, sizeof(blocks));
+    memset(ram_code_chunks, 0, sizeof(ram_code_chunks));
+    ram_generation = 0;
+    block_cache_epoch = 0;
+    block_fetch_ptr = nullptr;
+}
+
+const cpu_block *block_cache_lookup(uint16_t pc) {
+    uint16_t bank;
+    if (pc < 0x8000) {
+        bank = cart_rom_bank(pc);
+    } else if (ram_chunk(pc) >= 0) {
+        bank = BLOCK_RAM_BANK;
+    } else {
+        return nullptr;
+    }
+
+    cpu_block &block = blocks[(pc + bank * 0x9E5u) & (BLOCK_CACHE_SIZE - 1)];
+    if (!block.valid || block.pc != pc || block.bank != bank ||
+        (bank == BLOCK_RAM_BANK && block.generation != ram_generation)) {
+        build_block(block, pc, bank);
+    }
+    return &block;
+}
+
+void block_cache_write(uint16_t addr) {
+    if (addr < 0x8000) {
+        block_cache_epoch++;
+        return;
+    }
+
+    // Echo RAM writes land in WRAM.
+    if (addr >= 0xE000 && addr < 0xFE00) {
+        addr = static_cast<uint16_t>(addr - 0x2000);
+    }
+
+    int chunk = ram_chunk(addr);
+    if (chunk >= 0 && ram_code_chunks[chunk]) {
+        ram_generation++;
+        memset(ram_code_chunks, 0, sizeof(ram_code_chunks));
+        block_cache_epoch++;
+    }
+}
+
+void block_cache_write_range(uint16_t addr, uint16_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    // One write per chunk touched is enough to catch cached code in it.
+    uint32_t end = static_cast<uint32_t>(addr) + count;
+    for (uint32_t a = addr; a < end; a = (a | ((1u << RAM_CHUNK_SHIFT) - 1)) + 1) {
+        block_cache_write(static_cast<uint16_t>(a));
+    }
+}
@@ -4,6 +4,12 @@
 #include "io.h"
 #include "cpu.h"
 #include "emu.h"
+#include "interrupt.h"
+#include "ppu.h"
+#ifdef CPU_BLOCK_CACHE
+#include "block_cache.h"
+#endif
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
 #include <cstdio>
@@ -15,73 +21,111 @@
 
 extern Ram ram;
 
-uint8_t bus_read(uint16_t addr) {
-    // ROM / cartridge
-    if (addr < 0x8000) {
-        return cart_read(addr);
-    }
-    else if (addr < 0xA000) { // vram
-        return vram_read(addr - 0x8000);
-    }
-    else if (addr < 0xC000) { // external ram (cartridge RAM)
-        return cart_read(addr);
-    }
-    else if (addr < 0xE000) { // work ram
-        return wram_read(addr - 0xC000);
-    }
-    else if (addr < 0xFE00) { // echo ram
-        return wram_read(addr - 0xE000);
-    }
-    else if (addr < 0xFEA0) { // OAM (Object Attribute Memory)
-        return ram.oam[addr - 0xFE00];
-    }
-    else if (addr < 0xFF00) { // unusable memory area
-        return 0xFF;
+// VRAM reads are plain memory, but the PPU catches up before a write changes
+// what it draws (0x8000-0x9FFF).
+static void vram_page_write(uint16_t addr, uint8_t val) {
+    ppu_sync();
+    vram_write(static_cast<uint16_t>(addr - 0x8000), val);
+}
+
+// OAM and the unusable area after it (0xFE00-0xFEFF).
+static uint8_t oam_page_read(uint16_t addr) {
+    return addr < 0xFEA0 ? ram.oam[addr - 0xFE00] : 0xFF;
+}
+
+static void oam_page_write(uint16_t addr, uint8_t val) {
+    if (addr < 0xFEA0) {
+        ppu_sync();
+        ram.oam[addr - 0xFE00] = val;
     }
-    else if (addr < 0xFF80) { // io registers
+}
+
+// IO registers, high ram and IE (0xFF00-0xFFFF).
+static uint8_t high_page_read(uint16_t addr) {
+    if (addr < 0xFF80) {
         return io_read(addr);
     }
-    else if (addr < 0xFFFF) { // high ram
+    if (addr < 0xFFFF) {
         return hram_read(addr - 0xFF80);
     }
-    else if (addr == 0xFFFF) { // IE
-        return ram.ie;
+    return ram.ie;
+}
+
+static void high_page_write(uint16_t addr, uint8_t val) {
+    if (addr < 0xFF80) {
+        io_write(addr, val);
+    } else if (addr < 0xFFFF) {
+        hram_write(addr - 0xFF80, val);
+    } else {
+        ram.ie = val;
+        interrupt_flags_changed();
     }
+}
+
+static bus_page_table build_page_table() {
+    bus_page_table t{};
+    for (int page = 0; page < 0x100; page++) {
+        uint8_t *mem = nullptr;
+        if (page >= 0x80 && page < 0xA0) {          // vram
+            mem = &ram.vram[0][(page - 0x80) << 8];
+        } else if (page >= 0xC0 && page < 0xE0) {   // work ram (both banks are contiguous)
+            mem = &ram.wram[0][0] + ((page - 0xC0) << 8);
+        } else if (page >= 0xE0 && page < 0xFE) {   // echo ram
+            mem = &ram.wram[0][0] + ((page - 0xE0) << 8);
+        }
+        t.read[page] = mem;
+        t.write[page] = mem;
 
+        if (page < 0x80 || (page >= 0xA0 && page < 0xC0)) {  // rom / cart ram, see bus_map_cart
+            t.read_handler[page] = cart_read;
+            t.write_handler[page] = cart_write;
+        } else if (page < 0xA0) {
+            t.write[page] = nullptr;
+            t.write_handler[page] = vram_page_write;
+        } else if (page == 0xFE) {
+            t.read_handler[page] = oam_page_read;
+            t.write_handler[page] = oam_page_write;
+        } else if (page == 0xFF) {
+            t.read_handler[page] = high_page_read;
+            t.write_handler[page] = high_page_write;
+        }
+    }
+    return t;
+}
+
+bus_page_table bus_pages = build_page_table();
+
+// While OAM DMA runs the CPU only reaches the IO/HRAM page.
+static uint8_t dma_locked_read(uint16_t) {
     return 0xFF;
 }
 
-void bus_write(uint16_t addr, uint8_t val) {
-    // ROM / cartridge
-    if (addr < 0x8000) {
-        cart_write(addr, val);
-    }
-    else if (addr < 0xA000) { // vram
-        vram_write(addr - 0x8000, val);
-    }
-    else if (addr < 0xC000) { // external ram (cartridge RAM)
-        cart_write(addr, val);
-    }
-    else if (addr < 0xE000) { // work ram
-        wram_write(addr - 0xC000, val);
-    }
-    else if (addr < 0xFE00) { // echo ram - mirrors WRAM (0xC000-0xDDFF)
-        wram_write(addr - 0xE000, val);
-    }
-    else if (addr < 0xFEA0) { // OAM (Object Attribute Memory)
-        ram.oam[addr - 0xFE00] = val;
-    }
-    else if (addr < 0xFF00) { // unusable memory area
+static void dma_locked_write(uint16_t, uint8_t) {
+}
 
+void bus_dma_lock(bool locked) {
+    if (!locked) {
+        bus_pages = build_page_table();
+        bus_map_cart();
+        return;
+    }
+    for (int page = 0; page < 0xFF; page++) {
+        bus_pages.read[page] = nullptr;
+        bus_pages.write[page] = nullptr;
+        bus_pages.read_handler[page] = dma_locked_read;
+        bus_pages.write_handler[page] = dma_locked_write;
     }
-    else if (addr < 0xFF80) { // io registers
-        io_write(addr, val);
-    }
-    else if (addr < 0xFFFF) { // high ram
-        hram_write(addr - 0xFF80, val);
+}
+
+void bus_map_cart() {
+    // ROM writes are MBC register writes, so ROM pages only get a read pointer.
+    for (int page = 0x00; page < 0x80; page++) {
+        bus_pages.read[page] = cart_page(static_cast<uint16_t>(page << 8));
     }
-    else if (addr == 0xFFFF) { // IE
-        ram.ie = val;
+    for (int page = 0xA0; page < 0xC0; page++) {
+        uint8_t *mem = cart_page(static_cast<uint16_t>(page << 8));
+        bus_pages.read[page] = mem;
+        bus_pages.write[page] = mem;
     }
 }
 
@@ -95,4 +139,92 @@ void bus_write16(uint16_t addr, uint16_t val) {
     // Game Boy is little-endian: low byte at addr, high byte at addr+1.
     bus_write(addr + 1, (val >> 8) & 0xFF);
     bus_write(addr,     val & 0xFF);
-}
\ No newline at end of file
+}
+
+// Host pointer for [addr, addr + count) when it lies entirely in VRAM, WRAM
+// or HRAM (plain memory), otherwise nullptr. Writing a VRAM span must sync
+// the PPU first, see bus_span_write.
+static uint8_t *bus_ram_span(uint16_t addr, uint16_t count) {
+    uint32_t end = static_cast<uint32_t>(addr) + count;
+    if (addr >= 0x8000 && end <= 0xA000) {
+        return &ram.vram[0][addr - 0x8000];
+    }
+    if (addr >= 0xC000 && end <= 0xE000) {
+        return &ram.wram[0][0] + (addr - 0xC000);  // both banks are contiguous
+    }
+    if (addr >= 0xFF80 && end <= 0xFFFF) {
+        return &ram.hram[addr - 0xFF80];
+    }
+    return nullptr;
+}
+
+// Bookkeeping before [dst, dst + count) of plain RAM is written directly.
+static void bus_span_write(uint16_t dst, uint16_t count) {
+#ifdef CPU_BLOCK_CACHE
+    block_cache_write_range(dst, count);
+#else
+    (void)count;
+#endif
+    if (dst < 0xA000) {
+        ppu_sync();
+        ppu_vram_written(static_cast<uint16_t>(dst - 0x8000), count);
+    }
+}
+
+// True when [addr, addr + count) lies in ROM or cart RAM pages currently
+// mapped to host memory. Each page is contiguous; consecutive pages need not
+// be (banks, and cart_page() per 256 bytes).
+static bool bus_cart_span(uint16_t addr, uint16_t count) {
+    uint32_t end = static_cast<uint32_t>(addr) + count;
+    if (!(end <= 0x8000 || (addr >= 0xA000 && end <= 0xC000))) {
+        return false;
+    }
+    for (uint32_t page = addr >> 8; page < (end + 0xFF) >> 8; page++) {
+        if (!bus_pages.read[page]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void bus_copy(uint16_t dst, uint16_t src, uint16_t count) {
+    uint8_t *to = bus_ram_span(dst, count);
+    const uint8_t *from = bus_ram_span(src, count);
+    bool overlapping = dst > src && dst < static_cast<uint32_t>(src) + count;
+
+    if (to && from && !overlapping) {
+        bus_span_write(dst, count);
+        memmove(to, from, count);
+        return;
+    }
+
+    // ROM/cart RAM to RAM (e.g. tile data into VRAM): one page at a time.
+    if (to && bus_cart_span(src, count)) {
+        bus_span_write(dst, count);
+        while (count) {
+            uint16_t chunk = std::min<uint16_t>(count, 0x100 - (src & 0xFF));
+            memcpy(to, bus_pages.read[src >> 8] + (src & 0xFF), chunk);
+            to += chunk;
+            src = static_cast<uint16_t>(src + chunk);
+            count = static_cast<uint16_t>(count - chunk);
+        }
+        return;
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+        bus_write(static_cast<uint16_t>(dst + i), bus_read(static_cast<uint16_t>(src + i)));
+    }
+}
+
+void bus_fill(uint16_t dst, uint8_t value, uint16_t count) {
+    uint8_t *to = bus_ram_span(dst, count);
+    if (to) {
+        bus_span_write(dst, count);
+        memset(to, value, count);
+        return;
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+        bus_write(static_cast<uint16_t>(dst + i), value);
+    }
+}
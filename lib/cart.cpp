@@ -1,9 +1,18 @@
 #include "cart.h"
+#include "bus.h"
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <cstdint>
 
+// One per MBC type, chosen in cart_load. `map` recomputes the bank pointers
+// below from the banking registers; `write` calls it after a register write.
+typedef struct {
+    uint8_t (*read)(uint16_t address);
+    void (*write)(uint16_t address, uint8_t value);
+    void (*map)();
+} cart_controller;
+
 typedef struct {
     char filename[1024];
     uint32_t rom_size;
@@ -33,21 +42,20 @@ typedef struct {
     uint32_t ram_size_bytes;
     uint8_t num_ram_banks;
     uint16_t num_rom_banks;
+
+    // Current mapping: ROM at 0x0000/0x4000 and cart RAM at 0xA000
+    // (nullptr when disabled, absent or replaced by an RTC register).
+    const cart_controller *controller;
+    uint8_t *rom_lo;
+    uint8_t *rom_hi;
+    uint16_t rom_lo_bank;
+    uint16_t rom_hi_bank;
+    uint8_t *ram_base;
 } cart_context;
 
 static cart_context ctx;
 
-static bool cart_is_mbc1() {
-    return ctx.header->type >= 0x01 && ctx.header->type <= 0x03;
-}
-
-static bool cart_is_mbc3() {
-    return ctx.header->type >= 0x0F && ctx.header->type <= 0x13;
-}
-
-static bool cart_is_mbc5() {
-    return ctx.header->type >= 0x19 && ctx.header->type <= 0x1E;
-}
+static const cart_controller *cart_controller_for(uint8_t type);
 
 static bool cart_has_rtc() {
     return ctx.header->type == 0x0F || ctx.header->type == 0x10;
@@ -141,6 +149,19 @@ bool cart_load(const char *cart) {
     printf("\t ROM Vers : %2.2X\n", ctx.header->version);
 
     ctx.num_rom_banks = 2 << ctx.header->rom_size;
+    ctx.controller = cart_controller_for(ctx.header->type);
+
+    // Pad the image to whole banks so every mapped bank is a plain pointer:
+    // MBC reads wrap around the image, ROM-only reads past it are open bus.
+    uint32_t image_size = ctx.num_rom_banks * 0x4000u;
+    if (image_size > ctx.rom_size) {
+        bool rom_only = ctx.controller == cart_controller_for(0x00);
+        ctx.rom_data = (uint8_t *)realloc(ctx.rom_data, image_size);
+        for (uint32_t i = ctx.rom_size; i < image_size; i++) {
+            ctx.rom_data[i] = rom_only ? 0xFF : ctx.rom_data[i % ctx.rom_size];
+        }
+        ctx.header = (rom_header *)(ctx.rom_data + 0x100);
+    }
 
     // Common defaults
     ctx.ram_enabled = false;
@@ -176,11 +197,20 @@ bool cart_load(const char *cart) {
 
     printf("\t Checksum : %2.2X (%s)\n", ctx.header->checksum, (x & 0xFF) ? "PASSED" : "FAILED");
 
+    ctx.controller->map();
+    bus_map_cart();
+
     return true;
 }
 
+// ---- ROM only ----
+
 static uint8_t rom_only_read(uint16_t address) {
-    return ctx.rom_data[address];
+    if (address < 0x8000) {
+        return ctx.rom_data[address];  // padded with 0xFF past the image
+    }
+    // No cartridge RAM: 0xA000-0xBFFF reads open bus.
+    return 0xFF;
 }
 
 static void rom_only_write(uint16_t address, uint8_t value) {
@@ -188,135 +218,122 @@ static void rom_only_write(uint16_t address, uint8_t value) {
     (void)value;
 }
 
-static uint8_t mbc1_read(uint16_t address) {
+static void rom_only_map() {
+    ctx.rom_lo = ctx.rom_data;
+    ctx.rom_hi = ctx.rom_data + 0x4000;
+    ctx.rom_lo_bank = 0;
+    ctx.rom_hi_bank = 1;
+    ctx.ram_base = nullptr;
+}
+
+// ---- shared by the MBCs ----
+
+// Point the ROM windows at banks lo/hi (already masked to the image).
+static void map_rom(uint16_t lo, uint16_t hi) {
+    ctx.rom_lo_bank = lo;
+    ctx.rom_hi_bank = hi;
+    ctx.rom_lo = ctx.rom_data + lo * 0x4000u;
+    ctx.rom_hi = ctx.rom_data + hi * 0x4000u;
+}
+
+static void map_ram(uint32_t bank) {
+    ctx.ram_base = (ctx.ram_enabled && ctx.ram_data) ? ctx.ram_data + bank * 0x2000u : nullptr;
+}
+
+static uint8_t banked_read(uint16_t address) {
     if (address < 0x4000) {
-        uint32_t bank = 0;
-        if (ctx.banking_mode == 1) {
-            bank = (ctx.ram_bank_reg << 5) & (ctx.num_rom_banks - 1);
-        }
-        uint32_t rom_addr = bank * 0x4000 + address;
-        return ctx.rom_data[rom_addr % ctx.rom_size];
+        return ctx.rom_lo[address];
     }
-
     if (address < 0x8000) {
-        uint32_t bank = (ctx.ram_bank_reg << 5) | ctx.rom_bank_reg;
-        bank &= (ctx.num_rom_banks - 1);
-        uint32_t rom_addr = bank * 0x4000 + (address - 0x4000);
-        return ctx.rom_data[rom_addr % ctx.rom_size];
+        return ctx.rom_hi[address - 0x4000];
     }
+    if (address >= 0xA000 && address < 0xC000 && ctx.ram_base) {
+        return ctx.ram_base[address - 0xA000];
+    }
+    return 0xFF;
+}
 
-    if (address >= 0xA000 && address < 0xC000) {
-        if (!ctx.ram_enabled || !ctx.ram_data) {
-            return 0xFF;
-        }
-        uint32_t ram_bank = 0;
-        if (ctx.banking_mode == 1 && ctx.num_ram_banks > 1) {
-            ram_bank = ctx.ram_bank_reg & (ctx.num_ram_banks - 1);
-        }
-        uint32_t ram_addr = ram_bank * 0x2000 + (address - 0xA000);
-        return ctx.ram_data[ram_addr % ctx.ram_size_bytes];
+static void banked_ram_write(uint16_t address, uint8_t value) {
+    if (address >= 0xA000 && address < 0xC000 && ctx.ram_base) {
+        ctx.ram_base[address - 0xA000] = value;
     }
+}
 
-    return 0xFF;
+// ---- MBC1 ----
+
+static void mbc1_map() {
+    uint16_t mask = ctx.num_rom_banks - 1;
+    uint16_t lo = ctx.banking_mode == 1 ? ((ctx.ram_bank_reg << 5) & mask) : 0;
+    map_rom(lo, ((ctx.ram_bank_reg << 5) | ctx.rom_bank_reg) & mask);
+
+    uint32_t ram_bank = 0;
+    if (ctx.banking_mode == 1 && ctx.num_ram_banks > 1) {
+        ram_bank = ctx.ram_bank_reg & (ctx.num_ram_banks - 1);
+    }
+    map_ram(ram_bank);
 }
 
 static void mbc1_write(uint16_t address, uint8_t value) {
     if (address < 0x2000) {
         ctx.ram_enabled = ((value & 0x0F) == 0x0A);
-        return;
-    }
-
-    if (address < 0x4000) {
+    } else if (address < 0x4000) {
         ctx.rom_bank_reg = value & 0x1F;
         if (ctx.rom_bank_reg == 0) {
             ctx.rom_bank_reg = 1;
         }
-        return;
-    }
-
-    if (address < 0x6000) {
+    } else if (address < 0x6000) {
         ctx.ram_bank_reg = value & 0x03;
-        return;
-    }
-
-    if (address < 0x8000) {
+    } else if (address < 0x8000) {
         ctx.banking_mode = value & 0x01;
+    } else {
+        banked_ram_write(address, value);
         return;
     }
-
-    if (address >= 0xA000 && address < 0xC000) {
-        if (!ctx.ram_enabled || !ctx.ram_data) {
-            return;
-        }
-        uint32_t ram_bank = 0;
-        if (ctx.banking_mode == 1 && ctx.num_ram_banks > 1) {
-            ram_bank = ctx.ram_bank_reg & (ctx.num_ram_banks - 1);
-        }
-        uint32_t ram_addr = ram_bank * 0x2000 + (address - 0xA000);
-        ctx.ram_data[ram_addr % ctx.ram_size_bytes] = value;
-        return;
-    }
+    mbc1_map();
 }
 
-static uint8_t mbc3_read(uint16_t address) {
-    // 0x0000-0x3FFF: ROM bank 0 (fixed)
-    if (address < 0x4000) {
-        return ctx.rom_data[address];
-    }
+// ---- MBC3 ----
 
-    // 0x4000-0x7FFF: switchable ROM bank 1-127
-    if (address < 0x8000) {
-        uint32_t bank = ctx.rom_bank & (ctx.num_rom_banks - 1);
-        uint32_t rom_addr = bank * 0x4000 + (address - 0x4000);
-        return ctx.rom_data[rom_addr % ctx.rom_size];
-    }
-
-    // 0xA000-0xBFFF: external RAM or RTC register
-    if (address >= 0xA000 && address < 0xC000) {
-        if (!ctx.ram_enabled) {
-            return 0xFF;
-        }
+static void mbc3_map() {
+    map_rom(0, ctx.rom_bank & (ctx.num_rom_banks - 1));
 
-        if (ctx.rtc_mapped && cart_has_rtc()) {
-            uint8_t idx = ctx.rtc_select - 0x08;
-            if (idx < 5) {
-                return ctx.rtc_latched[idx];
-            }
-            return 0xFF;
-        }
+    uint32_t ram_bank = ctx.ram_bank_reg;
+    if (ctx.num_ram_banks > 0) {
+        ram_bank &= (ctx.num_ram_banks - 1);
+    }
+    map_ram(ram_bank);
+    // With an RTC register selected, 0xA000-0xBFFF is the register.
+    if (ctx.rtc_mapped && cart_has_rtc()) {
+        ctx.ram_base = nullptr;
+    }
+}
 
-        if (!ctx.ram_data) {
-            return 0xFF;
-        }
-        uint32_t ram_bank = ctx.ram_bank_reg;
-        if (ctx.num_ram_banks > 0) {
-            ram_bank &= (ctx.num_ram_banks - 1);
+static uint8_t mbc3_read(uint16_t address) {
+    // 0xA000-0xBFFF: RTC register
+    if (address >= 0xA000 && address < 0xC000 && ctx.ram_enabled && ctx.rtc_mapped && cart_has_rtc()) {
+        uint8_t idx = ctx.rtc_select - 0x08;
+        if (idx < 5) {
+            return ctx.rtc_latched[idx];
         }
-        uint32_t ram_addr = ram_bank * 0x2000 + (address - 0xA000);
-        return ctx.ram_data[ram_addr % ctx.ram_size_bytes];
+        return 0xFF;
     }
-
-    return 0xFF;
+    return banked_read(address);
 }
 
 static void mbc3_write(uint16_t address, uint8_t value) {
     // 0x0000-0x1FFF: RAM & Timer enable
     if (address < 0x2000) {
         ctx.ram_enabled = ((value & 0x0F) == 0x0A);
-        return;
     }
-
     // 0x2000-0x3FFF: ROM bank number (7 bits, 0 maps to 1)
-    if (address < 0x4000) {
+    else if (address < 0x4000) {
         ctx.rom_bank = value & 0x7F;
         if (ctx.rom_bank == 0) {
             ctx.rom_bank = 1;
         }
-        return;
     }
-
     // 0x4000-0x5FFF: RAM bank or RTC register select
-    if (address < 0x6000) {
+    else if (address < 0x6000) {
         if (value <= 0x03) {
             ctx.ram_bank_reg = value;
             ctx.rtc_mapped = false;
@@ -324,127 +341,113 @@ static void mbc3_write(uint16_t address, uint8_t value) {
             ctx.rtc_select = value;
             ctx.rtc_mapped = true;
         }
-        return;
     }
-
     // 0x6000-0x7FFF: latch clock data (write 0x00 then 0x01)
-    if (address < 0x8000) {
+    else if (address < 0x8000) {
         if (ctx.rtc_latch_prev == 0x00 && value == 0x01) {
             memcpy(ctx.rtc_latched, ctx.rtc_regs, sizeof(ctx.rtc_regs));
         }
         ctx.rtc_latch_prev = value;
         return;
     }
-
     // 0xA000-0xBFFF: external RAM or RTC register write
-    if (address >= 0xA000 && address < 0xC000) {
-        if (!ctx.ram_enabled) {
-            return;
-        }
-
-        if (ctx.rtc_mapped && cart_has_rtc()) {
+    else {
+        if (address >= 0xA000 && address < 0xC000 && ctx.ram_enabled && ctx.rtc_mapped && cart_has_rtc()) {
             uint8_t idx = ctx.rtc_select - 0x08;
             if (idx < 5) {
                 ctx.rtc_regs[idx] = value;
             }
             return;
         }
-
-        if (!ctx.ram_data) {
-            return;
-        }
-        uint32_t ram_bank = ctx.ram_bank_reg;
-        if (ctx.num_ram_banks > 0) {
-            ram_bank &= (ctx.num_ram_banks - 1);
-        }
-        uint32_t ram_addr = ram_bank * 0x2000 + (address - 0xA000);
-        ctx.ram_data[ram_addr % ctx.ram_size_bytes] = value;
+        banked_ram_write(address, value);
         return;
     }
+    mbc3_map();
 }
 
-static uint8_t mbc5_read(uint16_t address) {
-    // 0x0000-0x3FFF: ROM bank 0 (fixed)
-    if (address < 0x4000) {
-        return ctx.rom_data[address];
-    }
+// ---- MBC5 ----
 
-    // 0x4000-0x7FFF: switchable ROM bank 0-511
-    if (address < 0x8000) {
-        uint32_t bank = ctx.rom_bank;
-        if (ctx.num_rom_banks > 0) {
-            bank &= (ctx.num_rom_banks - 1);
-        }
-        uint32_t rom_addr = bank * 0x4000 + (address - 0x4000);
-        return ctx.rom_data[rom_addr % ctx.rom_size];
-    }
+static void mbc5_map() {
+    map_rom(0, ctx.rom_bank & (ctx.num_rom_banks - 1));
 
-    // 0xA000-0xBFFF: external RAM
-    if (address >= 0xA000 && address < 0xC000) {
-        if (!ctx.ram_enabled || !ctx.ram_data) {
-            return 0xFF;
-        }
-        uint32_t ram_bank = ctx.ram_bank_reg;
-        if (ctx.num_ram_banks > 0) {
-            ram_bank &= (ctx.num_ram_banks - 1);
-        }
-        uint32_t ram_addr = ram_bank * 0x2000 + (address - 0xA000);
-        return ctx.ram_data[ram_addr % ctx.ram_size_bytes];
+    uint32_t ram_bank = ctx.ram_bank_reg;
+    if (ctx.num_ram_banks > 0) {
+        ram_bank &= (ctx.num_ram_banks - 1);
     }
-
-    return 0xFF;
+    map_ram(ram_bank);
 }
 
 static void mbc5_write(uint16_t address, uint8_t value) {
     // 0x0000-0x1FFF: RAM enable
     if (address < 0x2000) {
         ctx.ram_enabled = ((value & 0x0F) == 0x0A);
-        return;
     }
-
     // 0x2000-0x2FFF: low 8 bits of ROM bank
-    if (address < 0x3000) {
+    else if (address < 0x3000) {
         ctx.rom_bank = (ctx.rom_bank & 0x100) | value;
-        return;
     }
-
     // 0x3000-0x3FFF: bit 8 of ROM bank
-    if (address < 0x4000) {
+    else if (address < 0x4000) {
         ctx.rom_bank = (ctx.rom_bank & 0xFF) | ((value & 0x01) << 8);
-        return;
     }
-
     // 0x4000-0x5FFF: RAM bank (0x00-0x0F)
-    if (address < 0x6000) {
+    else if (address < 0x6000) {
         ctx.ram_bank_reg = value & 0x0F;
+    }
+    else if (address < 0x8000) {
         return;
     }
-
     // 0xA000-0xBFFF: external RAM write
-    if (address >= 0xA000 && address < 0xC000) {
-        if (!ctx.ram_enabled || !ctx.ram_data) {
-            return;
-        }
-        uint32_t ram_bank = ctx.ram_bank_reg;
-        if (ctx.num_ram_banks > 0) {
-            ram_bank &= (ctx.num_ram_banks - 1);
-        }
-        uint32_t ram_addr = ram_bank * 0x2000 + (address - 0xA000);
-        ctx.ram_data[ram_addr % ctx.ram_size_bytes] = value;
+    else {
+        banked_ram_write(address, value);
         return;
     }
+    mbc5_map();
+}
+
+static const cart_controller ROM_ONLY_CONTROLLER = {rom_only_read, rom_only_write, rom_only_map};
+static const cart_controller MBC1_CONTROLLER = {banked_read, mbc1_write, mbc1_map};
+static const cart_controller MBC3_CONTROLLER = {mbc3_read, mbc3_write, mbc3_map};
+static const cart_controller MBC5_CONTROLLER = {banked_read, mbc5_write, mbc5_map};
+
+static const cart_controller *cart_controller_for(uint8_t type) {
+    if (type >= 0x01 && type <= 0x03) return &MBC1_CONTROLLER;
+    if (type >= 0x0F && type <= 0x13) return &MBC3_CONTROLLER;
+    if (type >= 0x19 && type <= 0x1E) return &MBC5_CONTROLLER;
+    return &ROM_ONLY_CONTROLLER;
+}
+
+const rom_header *cart_header() {
+    return ctx.header;
+}
+
+uint16_t cart_rom_bank(uint16_t address) {
+    return address < 0x4000 ? ctx.rom_lo_bank : ctx.rom_hi_bank;
+}
+
+uint8_t *cart_page(uint16_t address) {
+    address &= 0xFF00;
+    if (address < 0x4000) {
+        return ctx.rom_lo + address;
+    }
+    if (address < 0x8000) {
+        return ctx.rom_hi + (address - 0x4000);
+    }
+    if (address >= 0xA000 && address < 0xC000 && ctx.ram_base) {
+        return ctx.ram_base + (address - 0xA000);
+    }
+    return nullptr;
 }
 
 uint8_t cart_read(uint16_t address) {
-    if (cart_is_mbc1()) return mbc1_read(address);
-    if (cart_is_mbc3()) return mbc3_read(address);
-    if (cart_is_mbc5()) return mbc5_read(address);
-    return rom_only_read(address);
+    return ctx.controller->read(address);
 }
 
 void cart_write(uint16_t address, uint8_t value) {
-    if (cart_is_mbc1()) { mbc1_write(address, value); return; }
-    if (cart_is_mbc3()) { mbc3_write(address, value); return; }
-    if (cart_is_mbc5()) { mbc5_write(address, value); return; }
-    rom_only_write(address, value);
+    ctx.controller->write(address, value);
+
+    // Register writes can change what is mapped where.
+    if (address < 0x8000) {
+        bus_map_cart();
+    }
 }
@@ -1,24 +1,40 @@
 #include "cpu.h"
 #include "cpu_instructions.h"
 #include "cpu_proc.h"
+#include "cpu_dispatch.h"
+#include "cpu_specialized.h"
+#ifdef CPU_BLOCK_CACHE
+#include "block_cache.h"
+#endif
+#ifdef CPU_FUSION
+#include "cpu_fusion.h"
+#ifdef CPU_THREADED
+#error "FUSION=1 fuses block cache instructions and needs the switch core"
+#endif
+#endif
+#if defined(CPU_THREADED) && defined(CPU_BLOCK_CACHE)
+#error "BLOCK_CACHE=1 and AOT=1 only run in the switch core's cpu_run"
+#endif
+#ifdef CPU_AOT
+#include "cpu_aot.h"
+#endif
+#ifdef CPU_TRACE
+#include "cpu_trace.h"
+#endif
+#ifdef CPU_STATS
+#include "cpu_stats.h"
+#endif
 #include "bus.h"
 #include "interrupt.h"
 #include "timer.h"
 #include "emu.h"
-#include <cstdio>
+#include "dma.h"
+#include "cpu_idle.h"
+#include "cpu_bulk.h"
 #include <cstdint>
-#include <unordered_map>
-#include <fstream>
-#include <iomanip>
-#include <string>
 
 cpu_state cpu;
 
-// Namespace to manage log state that can be reset
-namespace cpu_log_state {
-    bool should_reset = true;
-}
-
 enum class cb_target : uint8_t {
     B = 0,
     C = 1,
@@ -37,7 +53,7 @@ void cpu_init() {
     
     // AF = 0x01B0 (A=01, F=B0: Z=1, N=0, H=1, C=0)
     cpu.A = 0x01;
-    cpu.F = 0xB0;
+    cpu_set_flags(0xB0);
     
     // BC = 0x0013
     cpu.B = 0x00;
@@ -59,301 +75,381 @@ void cpu_init() {
     cpu.instr_count = 0;
     cpu.cycle_count = 0;
     
+    sched_init();
+    cpu_dispatch_init();
+#ifdef CPU_BLOCK_CACHE
+    block_cache_init();
+#endif
     timer_init();
-    
-    // Reset log file state so it's cleared on each run
-    cpu_log_state::should_reset = true;
 }
 
-uint8_t cpu_step() {
-    // Check serial output for "Passed" message
-    static std::string serial_buffer;
-    uint8_t sc = bus_read(0xFF02);
-    uint8_t sb = bus_read(0xFF01);
-    
-    // If serial transfer is active (SC bit 7 set), track the character
-    if (sc & 0x80) {
-        char c = static_cast<char>(sb);
-        serial_buffer += c;
-        
-        // Keep buffer size reasonable (last 10 characters)
-        if (serial_buffer.length() > 10) {
-            serial_buffer = serial_buffer.substr(serial_buffer.length() - 10);
-        }
-        
-        // Check if "Passed" appears in the buffer
-        if (serial_buffer.find("Passed") != std::string::npos) {
-            std::printf("\n*** PASSED ***\n");
-            fflush(stdout);
-        }
-    }
-    
-    uint8_t cycles = 0;
-    
+// Work done before every opcode fetch: EI delay, interrupt entry and HALT.
+// Returns the cycles spent when no opcode is dispatched this step, or 0 when
+// the caller should fetch and execute the next instruction.
+uint8_t cpu_step_begin() {
     if (cpu.ime_pending) {
         cpu.ime_pending = false;
         cpu.ime = true;
     }
     
-    if (cpu.ime) {
-        uint8_t interrupt_cycles = cpu_handle_interrupts(&cpu);
-        if (interrupt_cycles > 0) {
-            cpu.enabling_ime = false;  // Clear EI delay flag
-            return interrupt_cycles;
-        }
+    if (cpu.ime && interrupts_pending) {
+        cpu.enabling_ime = false;  // Clear EI delay flag
+        return cpu_handle_interrupts(&cpu);
     }
     
     cpu.enabling_ime = false;
-    
-    if (!cpu.halt) {
-        cpu.instr_count++;
-
-        uint16_t pc_before = cpu.PC;
-        cpu.last_opcode_pc = pc_before;  // Capture PC for accurate bus write logging
-
-        static std::ofstream log_file;
-        static uint64_t log_count = 0;
-        
-        if (cpu_log_state::should_reset) {
-            log_file.close();
-            log_file.open("cpu_log.txt", std::ios::trunc);
-            log_count = 0;
-            cpu_log_state::should_reset = false;
-        }
-        if (log_count < 100000 && log_file.is_open()) {
-            log_file << std::hex << std::uppercase << std::setfill('0');
-            log_file << "A:" << std::setw(2) << static_cast<int>(cpu.A)
-                     << " F:" << std::setw(2) << static_cast<int>(cpu.F)
-                     << " B:" << std::setw(2) << static_cast<int>(cpu.B)
-                     << " C:" << std::setw(2) << static_cast<int>(cpu.C)
-                     << " D:" << std::setw(2) << static_cast<int>(cpu.D)
-                     << " E:" << std::setw(2) << static_cast<int>(cpu.E)
-                     << " H:" << std::setw(2) << static_cast<int>(cpu.H)
-                     << " L:" << std::setw(2) << static_cast<int>(cpu.L)
-                     << " SP:" << std::setw(4) << cpu.SP
-                     << " PC:" << std::setw(4) << pc_before
-                     << " PCMEM:";
-            
-            for (int i = 0; i < 4; i++) {
-                if (i > 0) log_file << ",";
-                uint8_t mem_val = bus_read(static_cast<uint16_t>(pc_before + i));
-                log_file << std::setw(2) << static_cast<int>(mem_val);
-            }
-            log_file << "\n";
-            // Flush every 10k lines instead of every line (massive perf improvement)
-            if ((log_count & 0x2FFF) == 0) log_file.flush();
-            ++log_count;
+
+    if (cpu.halt) {
+        if (interrupts_pending) {
+            cpu.halt = false;
         }
+        return 4;
+    }
+
+    return 0;
+}
+
+// Bookkeeping for the instruction about to run at PC, including the trace.
+static inline void cpu_trace_instruction() {
+    cpu.instr_count++;
+    cpu.last_opcode_pc = cpu.PC;  // Capture PC for accurate bus write logging
+
+#ifdef CPU_TRACE
+    if (cpu_trace_enabled) {
+        cpu_trace_record(cpu.PC);
+    }
+#endif
+}
+
+// Compiled blocks don't record the trace, so cpu_run interprets while it is on.
+static inline bool cpu_tracing() {
+#ifdef CPU_TRACE
+    return cpu_trace_enabled;
+#else
+    return false;
+#endif
+}
+
+// Read the opcode at PC (a CB prefix is returned as-is for the caller to follow).
+static inline uint8_t cpu_fetch_opcode() {
+    cpu_trace_instruction();
 
     uint8_t op = bus_read(cpu.PC);
     cpu.PC = static_cast<uint16_t>(cpu.PC + 1);
+    return op;
+}
 
-    bool is_cb = false;
+// EI takes effect after the instruction that follows it.
+static inline void cpu_step_end() {
+    if (cpu.enabling_ime) {
+        cpu.enabling_ime = false;
+        cpu.ime_pending = true; 
+    }
+}
+
+uint8_t cpu_step() {
+    uint8_t cycles = cpu_step_begin();
+    if (cycles) {
+        return cycles;
+    }
 
+    uint16_t op = cpu_fetch_opcode();
     if (op == 0xCB) {
-        is_cb = true;
-        op = bus_read(cpu.PC);
+        op = CB_OPCODE_BASE | bus_read(cpu.PC);
         cpu.PC = static_cast<uint16_t>(cpu.PC + 1);
     }
 
-    Instruction inst = decode(op, is_cb);
+#ifdef CPU_STATS
+    cpu_stats_record(op);
+#endif
 
-    switch (inst.type) {
-        case in_type::IN_NOP: {
-            cycles = execute_nop(inst);
-            break;
-        }
-        case in_type::IN_LD: {
-            cycles = execute_ld(inst);
-            break;
-        }
-        case in_type::IN_INC: {
-            cycles = execute_inc(inst);
-            break;
-        }
-        case in_type::IN_DEC: {
-            cycles = execute_dec(inst);
-            break;
-        }
-        case in_type::IN_ADD: {
-            cycles = execute_add(inst);
-            break;
-        }
-        case in_type::IN_SUB: {
-            cycles = execute_sub(inst);
-            break;
-        }
-        case in_type::IN_RLCA: {
-            cycles = execute_rlca(inst);
-            break;
-        }
-        case in_type::IN_RRCA: {
-            cycles = execute_rrca(inst);
-            break;
-        }
-        case in_type::IN_RLA: {
-            cycles = execute_rla(inst);
-            break;
-        }
-        case in_type::IN_RRA: {
-            cycles = execute_rra(inst);
-            break;
-        }
-        case in_type::IN_DAA: {
-            cycles = execute_daa(inst);
-            break;
-        }
-        case in_type::IN_CPL: {
-            cycles = execute_cpl(inst);
-            break;
-        }
-        case in_type::IN_SCF: {
-            cycles = execute_scf(inst);
-            break;
-        }
-        case in_type::IN_CCF: {
-            cycles = execute_ccf(inst);
-            break;
-        }
-        case in_type::IN_JR: {
-            cycles = execute_jr(inst);
-            break;
-        }
-        case in_type::IN_STOP: {
-            cycles = execute_stop(inst);
-            break;
-        }
-        case in_type::IN_HALT: {
-            cycles = execute_halt(inst);
-            break;
-        }
-        case in_type::IN_ADC: {
-            cycles = execute_adc(inst);
-            break;
-        }
-        case in_type::IN_SBC: {
-            cycles = execute_sbc(inst);
-            break;
-        }
-        case in_type::IN_AND: {
-            cycles = execute_and(inst);
-            break;
-        }
-        case in_type::IN_XOR: {
-            cycles = execute_xor(inst);
-            break;
-        }
-        case in_type::IN_OR: {
-            cycles = execute_or(inst);
-            break;
-        }
-        case in_type::IN_CP: {
-            cycles = execute_cp(inst);
-            break;
-        }
-        case in_type::IN_RET: {
-            cycles = execute_ret(inst);
-            break;
-        }
-        case in_type::IN_RETI: {
-            cycles = execute_reti(inst);
-            break;
-        }
-        case in_type::IN_JP: {
-            cycles = execute_jp(inst);
-            break;
-        }
-        case in_type::IN_CALL: {
-            cycles = execute_call(inst);
-            break;
-        }
-        case in_type::IN_RST: {
-            cycles = execute_rst(inst);
-            break;
-        }
-        case in_type::IN_POP: {
-            cycles = execute_pop(inst);
-            break;
-        }
-        case in_type::IN_PUSH: {
-            cycles = execute_push(inst);
-            break;
-        }
-        case in_type::IN_LDH: {
-            cycles = execute_ldh(inst);
-            break;
-        }
-        case in_type::IN_DI: {
-            cycles = execute_di(inst);
-            break;
-        }
-        case in_type::IN_EI: {
-            cycles = execute_ei(inst);
-            break;
-        }
-        case in_type::IN_RLC: {
-            cycles = execute_rlc(inst);
-            break;
-        }
-        case in_type::IN_RRC: {
-            cycles = execute_rrc(inst);
-            break;
-        }
-        case in_type::IN_RL: {
-            cycles = execute_rl(inst);
-            break;
-        }
-        case in_type::IN_RR: {
-            cycles = execute_rr(inst);
-            break;
-        }
-        case in_type::IN_SLA: {
-            cycles = execute_sla(inst);
-            break;
-        }
-        case in_type::IN_SRA: {
-            cycles = execute_sra(inst);
-            break;
-        }
-        case in_type::IN_SWAP: {
-            cycles = execute_swap(inst);
-            break;
-        }
-        case in_type::IN_SRL: {
-            cycles = execute_srl(inst);
-            break;
-        }
-        case in_type::IN_BIT: {
-            uint8_t bit_to_check = (op >> 3) & 0x07;
-            cycles = execute_bit(inst, bit_to_check);
-            break;
+    const op_entry &entry = dispatch_table[op];
+    cycles = entry.handler(entry.inst);
+
+    cpu_step_end();
+    return cycles;
+}
+
+// While halted with nothing pending, every step is the same 4-cycle tick.
+// Run all the ticks before the next scheduled event (timer overflow, PPU
+// interrupt, serial completion) in one go, leaving that tick and the
+// last one of the budget to the normal path so wake-up and slice ends land
+// where single-stepping puts them. Joypad input only arrives between cpu_run
+// calls, so it cannot end a HALT early.
+static uint32_t cpu_halt_skip(uint32_t budget) {
+    if (!cpu.halt || interrupts_pending || dma_transferring()) {
+        return 0;
+    }
+
+    uint32_t next_event = sched_cycles_to_next_event(budget);
+    if (next_event == 0) {
+        return 0;
+    }
+    uint32_t skip = ((next_event - 1) / 4) * 4;
+    if (skip) {
+        emu_cycles(static_cast<int>(skip));
+    }
+    return skip;
+}
+
+// After a jump back: skip ahead through an idle poll loop, or bulk-run a
+// copy/fill loop. Neither applies while DMA holds the bus.
+static inline uint32_t cpu_loop_skip(uint32_t budget) {
+    if (dma_transferring()) {
+        return 0;
+    }
+    uint32_t skipped = cpu_idle_skip(budget);
+    return skipped ? skipped : cpu_bulk_skip(budget);
+}
+
+#ifndef CPU_THREADED
+
+#ifdef CPU_BLOCK_CACHE
+// Run the cached instruction `in` at pc through `execute` and tick it.
+template <typename Execute>
+static inline uint8_t cpu_run_cached(const block_instr &in, uint16_t pc, Execute execute) {
+    uint8_t prefix = (in.bytes[0] == 0xCB) ? 2 : 1;
+    cpu_trace_instruction();
+#ifdef CPU_STATS
+    cpu_stats_record(static_cast<uint16_t>(in.entry - dispatch_table.data()));
+#endif
+    cpu.PC = static_cast<uint16_t>(pc + prefix);
+    block_fetch_ptr = &in.bytes[prefix];
+    uint8_t step = execute();
+    block_fetch_ptr = nullptr;
+    cpu_step_end();
+
+    emu_cycles(step);
+    return step;
+}
+
+#ifdef CPU_FUSION
+// Both halves of a fused pair inlined into one handler. Between them it does
+// what cpu_run_block does between any two instructions.
+template <uint16_t FIRST, uint16_t SECOND>
+static uint32_t cpu_run_fused(const block_instr *in, uint16_t pc, uint32_t budget) {
+    uint32_t epoch = block_cache_epoch;
+    uint32_t elapsed = cpu_run_cached(in[0], pc, [] { return specialized::execute<FIRST>(); });
+    pc = static_cast<uint16_t>(pc + in[0].entry->length);
+    if (elapsed >= budget || cpu.PC != pc || block_cache_epoch != epoch) {
+        return elapsed;
+    }
+
+    uint8_t step = cpu_step_begin();
+    if (step) {
+        emu_cycles(step);
+        return elapsed + step;
+    }
+    return elapsed + cpu_run_cached(in[1], pc, [] { return specialized::execute<SECOND>(); });
+}
+
+// The most frequent adjacent pairs in opcode-pair profiles of our test ROMs:
+// copy/fill loop bodies, counted loops and register polls.
+#define CPU_FUSED_PAIR(first, second) {first, second, cpu_run_fused<first, second>}
+static const struct {
+    uint16_t first, second;
+    fused_handler fn;
+} fused_pairs[] = {
+    CPU_FUSED_PAIR(0x2A, 0x12),  // LD A,(HL+) / LD (DE),A
+    CPU_FUSED_PAIR(0x12, 0x13),  // LD (DE),A / INC DE
+    CPU_FUSED_PAIR(0x13, 0x0B),  // INC DE / DEC BC
+    CPU_FUSED_PAIR(0x0B, 0x78),  // DEC BC / LD A,B
+    CPU_FUSED_PAIR(0x78, 0xB1),  // LD A,B / OR C
+    CPU_FUSED_PAIR(0xB1, 0x20),  // OR C / JR NZ
+    CPU_FUSED_PAIR(0x3E, 0x22),  // LD A,n / LD (HL+),A
+    CPU_FUSED_PAIR(0x22, 0x0B),  // LD (HL+),A / DEC BC
+    CPU_FUSED_PAIR(0x05, 0x20),  // DEC B / JR NZ
+    CPU_FUSED_PAIR(0x0D, 0x20),  // DEC C / JR NZ
+    CPU_FUSED_PAIR(0xF0, 0xFE),  // LDH A,(n) / CP n
+    CPU_FUSED_PAIR(0xFE, 0x20),  // CP n / JR NZ
+    CPU_FUSED_PAIR(0xFE, 0x28),  // CP n / JR Z
+    CPU_FUSED_PAIR(0xB8, 0x28),  // CP B / JR Z
+    CPU_FUSED_PAIR(0xA7, 0x28),  // AND A / JR Z
+    CPU_FUSED_PAIR(0x00, 0x00),  // NOP / NOP
+};
+#undef CPU_FUSED_PAIR
+
+fused_handler cpu_fusion_lookup(uint16_t first, uint16_t second) {
+    for (const auto &pair : fused_pairs) {
+        if (pair.first == first && pair.second == second) {
+            return pair.fn;
         }
-        case in_type::IN_RES: {
-            uint8_t bit_to_clear = (op >> 3) & 0x07;
-            cycles = execute_res(inst, bit_to_clear);
+    }
+    return nullptr;
+}
+#endif
+
+// Run a predecoded block until it ends, something leaves it (taken branch,
+// interrupt, HALT, bank switch, write over cached code) or the budget is used.
+// Every instruction still goes through cpu_step_begin and is ticked on its own.
+static uint32_t cpu_run_block(const cpu_block *block, uint32_t budget) {
+    uint32_t elapsed = 0;
+    uint32_t epoch = block_cache_epoch;
+    uint16_t pc = block->pc;
+
+    for (uint8_t i = 0; i < block->count; i++) {
+        uint8_t step = cpu_step_begin();
+        if (step) {
+            emu_cycles(step);
+            elapsed += step;
             break;
         }
-        case in_type::IN_SET: {
-            uint8_t bit_to_set = (op >> 3) & 0x07;
-            cycles = execute_set(inst, bit_to_set);
-            break;
+
+        const block_instr &in = block->instrs[i];
+#ifdef CPU_FUSION
+        if (in.fused) {
+            elapsed += in.fused(&in, pc, budget - elapsed);
+            pc = static_cast<uint16_t>(pc + in.entry->length + block->instrs[++i].entry->length);
+        } else
+#endif
+        {
+            elapsed += cpu_run_cached(in, pc, [&in] { return in.entry->handler(in.entry->inst); });
+            pc = static_cast<uint16_t>(pc + in.entry->length);
         }
-        default: {
-            std::printf("Unknown instruction: %d\n", static_cast<int>(inst.type));
+        if (elapsed >= budget || cpu.PC != pc || block_cache_epoch != epoch) {
             break;
         }
     }
-    } else {
-        if (bus_read(0xFF0F) & bus_read(0xFFFF)) {
-            cpu.halt = false;
-        }
-        cycles += 4;
+    return elapsed;
+}
+#endif
+
+uint32_t cpu_run(uint32_t cycles) {
+    uint32_t elapsed = 0;
+    while (elapsed < cycles) {
+        if (cpu.halt) {
+            elapsed += cpu_halt_skip(cycles - elapsed);
+        } else if (cpu.PC <= cpu.last_opcode_pc) {
+            elapsed += cpu_loop_skip(cycles - elapsed);
+        }
+#if defined(CPU_AOT) || defined(CPU_BLOCK_CACHE)
+        // Compiled and cached code has its own copy of the instruction
+        // bytes; while DMA locks the bus, fetch through it instead.
+        if (dma_transferring()) {
+            uint8_t step = cpu_step();
+            emu_cycles(step);
+            elapsed += step;
+            continue;
+        }
+#endif
+#ifdef CPU_AOT
+        aot_block_fn aot = cpu_tracing() ? nullptr : cpu_aot_lookup(cpu.PC);
+        if (aot) {
+            elapsed += aot(cycles - elapsed);
+            continue;
+        }
+#endif
+#ifdef CPU_BLOCK_CACHE
+        const cpu_block *block = block_cache_lookup(cpu.PC);
+        if (block && block->count) {
+            elapsed += cpu_run_block(block, cycles - elapsed);
+            continue;
+        }
+#endif
+        uint8_t step = cpu_step();
+        emu_cycles(step);
+        elapsed += step;
     }
+    return elapsed;
+}
 
-    if (cpu.enabling_ime) {
-        cpu.enabling_ime = false;
-        cpu.ime_pending = true; 
+#else
+
+// Direct-threaded core: every opcode gets its own label, and each one ends by
+// ticking the machine and jumping straight to the next opcode's label instead
+// of returning to a shared dispatch point. Needs GCC/Clang labels-as-values.
+
+#define CPU_OPCODE_ROW(X, h) \
+    X(0x##h##0) X(0x##h##1) X(0x##h##2) X(0x##h##3) X(0x##h##4) X(0x##h##5) X(0x##h##6) X(0x##h##7) \
+    X(0x##h##8) X(0x##h##9) X(0x##h##A) X(0x##h##B) X(0x##h##C) X(0x##h##D) X(0x##h##E) X(0x##h##F)
+
+#define CPU_OPCODES(X) \
+    CPU_OPCODE_ROW(X, 0) CPU_OPCODE_ROW(X, 1) CPU_OPCODE_ROW(X, 2) CPU_OPCODE_ROW(X, 3) \
+    CPU_OPCODE_ROW(X, 4) CPU_OPCODE_ROW(X, 5) CPU_OPCODE_ROW(X, 6) CPU_OPCODE_ROW(X, 7) \
+    CPU_OPCODE_ROW(X, 8) CPU_OPCODE_ROW(X, 9) CPU_OPCODE_ROW(X, A) CPU_OPCODE_ROW(X, B) \
+    CPU_OPCODE_ROW(X, C) CPU_OPCODE_ROW(X, D) CPU_OPCODE_ROW(X, E) CPU_OPCODE_ROW(X, F)
+
+// JR and JP nn (conditional or not): the branches that can close an idle loop.
+static constexpr bool is_jump_opcode(uint16_t op) {
+    return op == 0x18 || op == 0x20 || op == 0x28 || op == 0x30 || op == 0x38 ||
+           op == 0xC3 || op == 0xC2 || op == 0xCA || op == 0xD2 || op == 0xDA;
+}
+
+uint32_t cpu_run(uint32_t cycles) {
+// 0xCB jumps to the prefix handler, which dispatches on the next byte.
+#define CPU_BASE_LABEL(op) (op) == 0xCB ? &&cb_prefix : &&base_##op,
+#define CPU_CB_LABEL(op) &&cb_##op,
+    static const void *const base_labels[256] = { CPU_OPCODES(CPU_BASE_LABEL) };
+    static const void *const cb_labels[256] = { CPU_OPCODES(CPU_CB_LABEL) };
+
+    uint32_t elapsed = 0;
+    uint8_t step = 0;
+
+    if (cycles == 0) {
+        return 0;
     }
 
-    return cycles;
-}
\ No newline at end of file
+// Tick the machine for the step that just finished, then either stop, take
+// the interrupt/HALT path, or jump to the next opcode's label. After a jump
+// back, see whether it closed an idle or copy/fill loop that can be skipped.
+#define CPU_DISPATCH_NEXT(jump)                         \
+    do {                                                \
+        emu_cycles(step);                               \
+        elapsed += step;                                \
+        if (elapsed >= cycles) return elapsed;          \
+        if ((jump) && cpu.PC <= cpu.last_opcode_pc)     \
+            elapsed += cpu_loop_skip(cycles - elapsed); \
+        step = cpu_step_begin();                        \
+        if (step) goto no_dispatch;                     \
+        goto *base_labels[cpu_fetch_opcode()];          \
+    } while (0)
+
+#ifdef CPU_STATS
+#define CPU_STATS_RECORD(op) cpu_stats_record(op)
+#else
+#define CPU_STATS_RECORD(op) ((void)0)
+#endif
+
+#define CPU_BASE_CASE(op)                               \
+    base_##op:                                          \
+        CPU_STATS_RECORD(op);                           \
+        step = specialized::execute<op>();              \
+        cpu_step_end();                                 \
+        CPU_DISPATCH_NEXT(is_jump_opcode(op));
+
+#define CPU_CB_CASE(op)                                 \
+    cb_##op:                                            \
+        CPU_STATS_RECORD(CB_OPCODE_BASE | op);          \
+        step = specialized::execute<CB_OPCODE_BASE | op>(); \
+        cpu_step_end();                                 \
+        CPU_DISPATCH_NEXT(false);
+
+    step = cpu_step_begin();
+    if (!step) {
+        goto *base_labels[cpu_fetch_opcode()];
+    }
+
+no_dispatch:
+    if (cpu.halt) {
+        elapsed += cpu_halt_skip(cycles - elapsed);
+    }
+    CPU_DISPATCH_NEXT(false);
+
+cb_prefix: {
+        uint8_t cb = bus_read(cpu.PC);
+        cpu.PC = static_cast<uint16_t>(cpu.PC + 1);
+        goto *cb_labels[cb];
+    }
+
+    CPU_OPCODES(CPU_BASE_CASE)
+    CPU_OPCODES(CPU_CB_CASE)
+
+#undef CPU_BASE_LABEL
+#undef CPU_CB_LABEL
+#undef CPU_DISPATCH_NEXT
+#undef CPU_BASE_CASE
+#undef CPU_CB_CASE
+#undef CPU_STATS_RECORD
+}
+
+#endif
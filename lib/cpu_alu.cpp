@@ -0,0 +1,114 @@
+#include "cpu_alu.h"
+#include <cstdint>
+
+// Exhaustive checks of the ALU flag functions, both the arithmetic forms
+// (alu_calc_*) and the tables built from them, against an independent
+// reference: per-nibble carry/borrow for the adds and subtracts, and DAA as
+// execute_daa computed it before cpu_alu.h. Run by the compiler so a wrong
+// flag never builds. Ranges are split so each check stays within the
+// compilers' constexpr step limits.
+
+// Z/H/C of a + b + carry and of a - b - carry (N is added by the caller).
+static constexpr uint8_t ref_add(unsigned a, unsigned b, unsigned carry) {
+    return (((a + b + carry) & 0xFF) == 0 ? FLAG_Z : 0)
+         | ((a & 0x0F) + (b & 0x0F) + carry > 0x0F ? FLAG_H : 0)
+         | (a + b + carry > 0xFF ? FLAG_C : 0);
+}
+
+static constexpr uint8_t ref_sub(unsigned a, unsigned b, unsigned carry) {
+    return (((a - b - carry) & 0xFF) == 0 ? FLAG_Z : 0)
+         | ((a & 0x0F) < (b & 0x0F) + carry ? FLAG_H : 0)
+         | (a < b + carry ? FLAG_C : 0);
+}
+
+static constexpr uint8_t ref_inc(unsigned a) {
+    return (((a + 1) & 0xFF) == 0 ? FLAG_Z : 0) | ((a & 0x0F) == 0x0F ? FLAG_H : 0);
+}
+
+static constexpr uint8_t ref_dec(unsigned a) {
+    return FLAG_N | (((a - 1) & 0xFF) == 0 ? FLAG_Z : 0) | ((a & 0x0F) == 0 ? FLAG_H : 0);
+}
+
+static constexpr uint16_t ref_daa(uint8_t a, uint8_t f) {
+    uint8_t correction = 0;
+    bool carry_out = false;
+
+    const bool n = (f & FLAG_N) != 0;
+    const bool h = (f & FLAG_H) != 0;
+    const bool c = (f & FLAG_C) != 0;
+
+    if (!n) {
+        if (h || (a & 0x0F) > 9) {
+            correction |= 0x06;
+        }
+        if (c || a > 0x99) {
+            correction |= 0x60;
+            carry_out = true;
+        }
+        a = static_cast<uint8_t>(a + correction);
+    } else {
+        if (h) correction |= 0x06;
+        if (c) correction |= 0x60;
+        a = static_cast<uint8_t>(a - correction);
+        carry_out = c;
+    }
+
+    f &= FLAG_N;
+    if (a == 0) f |= FLAG_Z;
+    if (carry_out) f |= FLAG_C;
+    return static_cast<uint16_t>((a << 8) | f);
+}
+
+// Every ADD/ADC/SUB/SBC/CP result for a in [a_lo, a_hi).
+static constexpr bool zhc_matches(unsigned a_lo, unsigned a_hi) {
+    for (unsigned a = a_lo; a < a_hi; a++) {
+        for (unsigned b = 0; b < 256; b++) {
+            for (unsigned carry = 0; carry < 2; carry++) {
+                uint16_t sum = static_cast<uint16_t>(a + b + carry);
+                uint16_t diff = static_cast<uint16_t>(static_cast<int>(a) - static_cast<int>(b) - static_cast<int>(carry));
+                uint8_t x = static_cast<uint8_t>(a), y = static_cast<uint8_t>(b);
+                uint8_t add = ref_add(a, b, carry), sub = ref_sub(a, b, carry);
+                if (alu_calc_zhc(x, y, sum) != add || alu_table_zhc(x, y, sum) != add) return false;
+                if (alu_calc_zhc(x, y, diff) != sub || alu_table_zhc(x, y, diff) != sub) return false;
+            }
+        }
+    }
+    return true;
+}
+
+// DAA for every A and every incoming F (including bits it ignores).
+static constexpr bool daa_matches(unsigned a_lo, unsigned a_hi) {
+    for (unsigned a = a_lo; a < a_hi; a++) {
+        for (unsigned f = 0; f < 256; f++) {
+            uint8_t x = static_cast<uint8_t>(a), g = static_cast<uint8_t>(f);
+            uint16_t expected = ref_daa(x, g);
+            if (alu_calc_daa(x, g) != expected || alu_table_daa(x, g) != expected) return false;
+        }
+    }
+    return true;
+}
+
+static constexpr bool inc_dec_match() {
+    for (unsigned a = 0; a < 256; a++) {
+        uint8_t x = static_cast<uint8_t>(a);
+        if (alu_calc_inc(x) != ref_inc(a) || alu_table_inc(x) != ref_inc(a)) return false;
+        if (alu_calc_dec(x) != ref_dec(a) || alu_table_dec(x) != ref_dec(a)) return false;
+    }
+    return true;
+}
+
+static_assert(inc_dec_match(), "INC/DEC flag tables");
+
+static_assert(zhc_matches(0x00, 0x20), "ADD/SUB flag table");
+static_assert(zhc_matches(0x20, 0x40), "ADD/SUB flag table");
+static_assert(zhc_matches(0x40, 0x60), "ADD/SUB flag table");
+static_assert(zhc_matches(0x60, 0x80), "ADD/SUB flag table");
+static_assert(zhc_matches(0x80, 0xA0), "ADD/SUB flag table");
+static_assert(zhc_matches(0xA0, 0xC0), "ADD/SUB flag table");
+static_assert(zhc_matches(0xC0, 0xE0), "ADD/SUB flag table");
+static_assert(zhc_matches(0xE0, 0x100), "ADD/SUB flag table");
+
+static_assert(daa_matches(0x00, 0x40), "DAA table");
+static_assert(daa_matches(0x40, 0x80), "DAA table");
+static_assert(daa_matches(0x80, 0xC0), "DAA table");
+static_assert(daa_matches(0xC0, 0x100), "DAA table");
@@ -0,0 +1,87 @@
+#include "cpu_aot.h"
+
+#ifdef CPU_AOT
+
+#include "cart.h"
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <dlfcn.h>
+
+// Open-addressed on (bank << 16 | pc); sized to at most half full at load.
+static std::vector<const aot_block *> table;
+static uint32_t table_mask = 0;
+
+static uint32_t slot_for(uint16_t bank, uint16_t pc) {
+    uint32_t key = (static_cast<uint32_t>(bank) << 16) | pc;
+    return (key * 2654435761u) >> 8;
+}
+
+static bool module_matches(const aot_module *module) {
+    const rom_header *header = cart_header();
+    if (module->version != AOT_MODULE_VERSION) {
+        printf("AOT: module version %u, expected %u\n", module->version, AOT_MODULE_VERSION);
+        return false;
+    }
+    if (module->build != aot_build_fingerprint()) {
+        printf("AOT: module build %08X, expected %08X (rebuild with the same LAZY_FLAGS/ALU_TABLES)\n",
+               module->build, aot_build_fingerprint());
+        return false;
+    }
+    if (memcmp(module->title, header->title, 15) != 0 || module->type != header->type ||
+        module->rom_size != header->rom_size || module->checksum != header->checksum) {
+        printf("AOT: module was built for a different ROM\n");
+        return false;
+    }
+    return true;
+}
+
+bool cpu_aot_load(const char *path) {
+    void *lib = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!lib) {
+        printf("AOT: %s\n", dlerror());
+        return false;
+    }
+
+    const aot_module *module = static_cast<const aot_module *>(dlsym(lib, "gb_aot_module"));
+    if (!module || !module_matches(module)) {
+        dlclose(lib);
+        return false;
+    }
+
+    uint32_t size = 64;
+    while (size < module->count * 2) {
+        size <<= 1;
+    }
+    table.assign(size, nullptr);
+    table_mask = size - 1;
+
+    for (uint32_t i = 0; i < module->count; i++) {
+        const aot_block *block = &module->blocks[i];
+        uint32_t slot = slot_for(block->bank, block->pc) & table_mask;
+        while (table[slot]) {
+            slot = (slot + 1) & table_mask;
+        }
+        table[slot] = block;
+    }
+
+    printf("AOT: loaded %u blocks from %s\n", module->count, path);
+    return true;
+}
+
+aot_block_fn cpu_aot_lookup(uint16_t pc) {
+    if (pc >= 0x8000 || table.empty()) {
+        return nullptr;
+    }
+
+    uint16_t bank = cart_rom_bank(pc);
+    for (uint32_t slot = slot_for(bank, pc) & table_mask; table[slot]; slot = (slot + 1) & table_mask) {
+        if (table[slot]->pc == pc && table[slot]->bank == bank) {
+            return table[slot]->fn;
+        }
+    }
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,216 @@
+#include "cpu_bulk.h"
+#include "cpu.h"
+#include "bus.h"
+#include "cart.h"
+#include "dma.h"
+#include "emu.h"
+#include "interrupt.h"
+#include "ppu.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+enum class bulk_op : uint8_t {
+    COPY_HL_TO_DE,  // LD A,(HL+) / LD (DE),A / INC DE
+    COPY_DE_TO_HL,  // LD A,(DE) / LD (HL+),A / INC DE
+    FILL_A,         // LD (HL+),A
+    FILL_IMM,       // LD A,n / LD (HL+),A
+};
+
+enum class bulk_counter : uint8_t {
+    BC,             // DEC BC / LD A,B / OR C
+    B,              // DEC B
+    C,              // DEC C
+};
+
+typedef struct {
+    uint8_t code[8];    // loop body up to and including the JR NZ opcode
+    uint8_t size;
+    uint8_t instrs;     // instructions per trip
+    bulk_op op;
+    bulk_counter counter;
+} bulk_idiom;
+
+// FILL_IMM's n (code[1]) matches any value.
+static const bulk_idiom kIdioms[] = {
+    {{0x2A, 0x12, 0x13, 0x0B, 0x78, 0xB1, 0x20}, 7, 7, bulk_op::COPY_HL_TO_DE, bulk_counter::BC},
+    {{0x1A, 0x22, 0x13, 0x0B, 0x78, 0xB1, 0x20}, 7, 7, bulk_op::COPY_DE_TO_HL, bulk_counter::BC},
+    {{0x2A, 0x12, 0x13, 0x05, 0x20},             5, 5, bulk_op::COPY_HL_TO_DE, bulk_counter::B},
+    {{0x1A, 0x22, 0x13, 0x05, 0x20},             5, 5, bulk_op::COPY_DE_TO_HL, bulk_counter::B},
+    {{0x2A, 0x12, 0x13, 0x0D, 0x20},             5, 5, bulk_op::COPY_HL_TO_DE, bulk_counter::C},
+    {{0x1A, 0x22, 0x13, 0x0D, 0x20},             5, 5, bulk_op::COPY_DE_TO_HL, bulk_counter::C},
+    {{0x22, 0x05, 0x20},                         3, 3, bulk_op::FILL_A,        bulk_counter::B},
+    {{0x22, 0x0D, 0x20},                         3, 3, bulk_op::FILL_A,        bulk_counter::C},
+    {{0x3E, 0x00, 0x22, 0x0B, 0x78, 0xB1, 0x20}, 7, 6, bulk_op::FILL_IMM,      bulk_counter::BC},
+};
+
+typedef struct {
+    uint16_t head;
+    uint16_t branch;
+    uint16_t bank;
+    bool valid;
+    const bulk_idiom *idiom;   // nullptr: not a known copy/fill loop
+    uint8_t imm;               // n for FILL_IMM
+
+    // Previous arrival at the head.
+    bool armed;
+    uint64_t ticks;
+    uint64_t instr_count;
+} bulk_loop;
+
+static bulk_loop loop;
+
+static const bulk_idiom *match_idiom(uint16_t head, uint16_t branch) {
+    // The JR NZ at `branch` must close the loop back to `head`.
+    if (bus_read(branch) != 0x20 ||
+        static_cast<uint16_t>(branch + 2 + static_cast<int8_t>(bus_read(static_cast<uint16_t>(branch + 1)))) != head) {
+        return nullptr;
+    }
+
+    for (const bulk_idiom &idiom : kIdioms) {
+        if (branch - head != idiom.size - 1) continue;
+        bool match = true;
+        for (uint8_t i = 0; i < idiom.size && match; i++) {
+            bool operand = idiom.op == bulk_op::FILL_IMM && i == 1;
+            match = operand || bus_read(static_cast<uint16_t>(head + i)) == idiom.code[i];
+        }
+        if (match) {
+            loop.imm = bus_read(static_cast<uint16_t>(head + 1));
+            return &idiom;
+        }
+    }
+    return nullptr;
+}
+
+// Reads must not touch IO/IE; writes must also stay out of ROM (MBC
+// registers) and the unusable/IO area. Neither may wrap past 0xFFFF.
+static bool bulk_read_ok(uint16_t addr, uint16_t count) {
+    uint32_t end = static_cast<uint32_t>(addr) + count;
+    return end <= 0xFFFF && (end <= 0xFF00 || addr >= 0xFF80);
+}
+
+static bool bulk_write_ok(uint16_t addr, uint16_t count) {
+    uint32_t end = static_cast<uint32_t>(addr) + count;
+    return addr >= 0x8000 && end <= 0xFFFF && (end <= 0xFEA0 || addr >= 0xFF80);
+}
+
+uint32_t cpu_bulk_skip(uint32_t budget) {
+    uint16_t head = cpu.PC;
+    uint16_t branch = cpu.last_opcode_pc;
+
+    if (branch >= 0x8000 || branch < head || branch - head > 8) {
+        loop.armed = false;
+        return 0;
+    }
+
+    uint16_t bank = cart_rom_bank(head);
+    if (!loop.valid || loop.head != head || loop.branch != branch || loop.bank != bank) {
+        loop.valid = true;
+        loop.head = head;
+        loop.branch = branch;
+        loop.bank = bank;
+        loop.armed = false;
+        loop.idiom = match_idiom(head, branch);
+    }
+    if (!loop.idiom) {
+        return 0;
+    }
+
+    const bulk_idiom &idiom = *loop.idiom;
+
+    // One clean trip since the last arrival (an interrupt handler would add
+    // instructions) gives the exact cycles per trip.
+    bool measured = loop.armed && cpu.instr_count - loop.instr_count == idiom.instrs;
+    uint32_t trip = static_cast<uint32_t>(sched.now - loop.ticks);
+
+    loop.armed = true;
+    loop.ticks = sched.now;
+    loop.instr_count = cpu.instr_count;
+
+    if (!measured || cpu.halt || cpu.ime_pending || cpu.enabling_ime ||
+        (cpu.ime && interrupts_pending) || dma_transferring()) {
+        return 0;
+    }
+
+    // Trips left, including the final one that falls through; that one is
+    // always left to the interpreter.
+    uint32_t remaining;
+    switch (idiom.counter) {
+        case bulk_counter::BC: remaining = cpu.BC; break;
+        case bulk_counter::B:  remaining = cpu.B ? cpu.B : 256; break;
+        default:               remaining = cpu.C ? cpu.C : 256; break;
+    }
+    if (remaining == 0) {
+        return 0;
+    }
+
+    // Copies into VRAM or OAM stop at the PPU's next mode or LY change, as
+    // the line it draws there sees only the bytes written so far.
+    uint32_t next_event = sched_cycles_to_next_event(budget);
+    uint16_t dst = idiom.op == bulk_op::COPY_HL_TO_DE ? cpu.DE : cpu.HL;
+    if (dst < 0xA000 || dst + remaining > 0xFE00) {
+        next_event = ppu_cycles_to_next_change(next_event);
+    }
+    uint32_t trips = std::min(remaining - 1, next_event ? (next_event - 1) / trip : 0);
+    if (trips == 0) {
+        return 0;
+    }
+
+    uint16_t count = static_cast<uint16_t>(trips);
+    uint16_t hl = cpu.HL;
+    uint16_t de = cpu.DE;
+    switch (idiom.op) {
+        case bulk_op::COPY_HL_TO_DE:
+            if (!bulk_read_ok(hl, count) || !bulk_write_ok(de, count)) return 0;
+            bus_copy(de, hl, count);
+            cpu.A = bus_read(static_cast<uint16_t>(hl + count - 1));
+            hl = static_cast<uint16_t>(hl + count);
+            de = static_cast<uint16_t>(de + count);
+            break;
+        case bulk_op::COPY_DE_TO_HL:
+            if (!bulk_read_ok(de, count) || !bulk_write_ok(hl, count)) return 0;
+            bus_copy(hl, de, count);
+            cpu.A = bus_read(static_cast<uint16_t>(de + count - 1));
+            hl = static_cast<uint16_t>(hl + count);
+            de = static_cast<uint16_t>(de + count);
+            break;
+        case bulk_op::FILL_A:
+            if (!bulk_write_ok(hl, count)) return 0;
+            bus_fill(hl, cpu.A, count);
+            hl = static_cast<uint16_t>(hl + count);
+            break;
+        case bulk_op::FILL_IMM:
+            if (!bulk_write_ok(hl, count)) return 0;
+            bus_fill(hl, loop.imm, count);
+            hl = static_cast<uint16_t>(hl + count);
+            break;
+    }
+    cpu.HL = hl;
+    cpu.DE = de;
+
+    // Counter and flags as the last skipped trip left them (never zero).
+    uint32_t left = remaining - trips;
+    switch (idiom.counter) {
+        case bulk_counter::BC:
+            cpu.BC = static_cast<uint16_t>(left);
+            cpu.A = cpu.B | cpu.C;
+            cpu_flags_logic(cpu.A, 0);
+            break;
+        case bulk_counter::B:
+            cpu.B = static_cast<uint8_t>(left);
+            cpu_flags_dec(static_cast<uint8_t>(left + 1), cpu.B);
+            break;
+        case bulk_counter::C:
+            cpu.C = static_cast<uint8_t>(left);
+            cpu_flags_dec(static_cast<uint8_t>(left + 1), cpu.C);
+            break;
+    }
+
+    uint32_t cycles = trips * trip;
+    emu_cycles(static_cast<int>(cycles));
+    cpu.instr_count += static_cast<uint64_t>(trips) * idiom.instrs;
+
+    loop.ticks = sched.now;
+    loop.instr_count = cpu.instr_count;
+    return cycles;
+}
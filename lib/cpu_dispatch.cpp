@@ -0,0 +1,82 @@
+#include "cpu_dispatch.h"
+#include "cpu_instructions.h"
+#include "cpu_proc.h"
+#include <cstdint>
+
+std::array<op_entry, 512> dispatch_table;
+
+// BIT/RES/SET take the bit index separately; the decoder already stores it in param.
+static uint8_t execute_bit_param(const Instruction& inst) {
+    return execute_bit(inst, inst.param);
+}
+
+static uint8_t execute_res_param(const Instruction& inst) {
+    return execute_res(inst, inst.param);
+}
+
+static uint8_t execute_set_param(const Instruction& inst) {
+    return execute_set(inst, inst.param);
+}
+
+static op_handler handler_for(in_type type) {
+    switch (type) {
+        case in_type::IN_NOP:  return execute_nop;
+        case in_type::IN_LD:   return execute_ld;
+        case in_type::IN_INC:  return execute_inc;
+        case in_type::IN_DEC:  return execute_dec;
+        case in_type::IN_ADD:  return execute_add;
+        case in_type::IN_SUB:  return execute_sub;
+        case in_type::IN_RLCA: return execute_rlca;
+        case in_type::IN_RRCA: return execute_rrca;
+        case in_type::IN_RLA:  return execute_rla;
+        case in_type::IN_RRA:  return execute_rra;
+        case in_type::IN_DAA:  return execute_daa;
+        case in_type::IN_CPL:  return execute_cpl;
+        case in_type::IN_SCF:  return execute_scf;
+        case in_type::IN_CCF:  return execute_ccf;
+        case in_type::IN_JR:   return execute_jr;
+        case in_type::IN_STOP: return execute_stop;
+        case in_type::IN_HALT: return execute_halt;
+        case in_type::IN_ADC:  return execute_adc;
+        case in_type::IN_SBC:  return execute_sbc;
+        case in_type::IN_AND:  return execute_and;
+        case in_type::IN_XOR:  return execute_xor;
+        case in_type::IN_OR:   return execute_or;
+        case in_type::IN_CP:   return execute_cp;
+        case in_type::IN_RET:  return execute_ret;
+        case in_type::IN_RETI: return execute_reti;
+        case in_type::IN_JP:   return execute_jp;
+        case in_type::IN_CALL: return execute_call;
+        case in_type::IN_RST:  return execute_rst;
+        case in_type::IN_POP:  return execute_pop;
+        case in_type::IN_PUSH: return execute_push;
+        case in_type::IN_LDH:  return execute_ldh;
+        case in_type::IN_DI:   return execute_di;
+        case in_type::IN_EI:   return execute_ei;
+        case in_type::IN_RLC:  return execute_rlc;
+        case in_type::IN_RRC:  return execute_rrc;
+        case in_type::IN_RL:   return execute_rl;
+        case in_type::IN_RR:   return execute_rr;
+        case in_type::IN_SLA:  return execute_sla;
+        case in_type::IN_SRA:  return execute_sra;
+        case in_type::IN_SWAP: return execute_swap;
+        case in_type::IN_SRL:  return execute_srl;
+        case in_type::IN_BIT:  return execute_bit_param;
+        case in_type::IN_RES:  return execute_res_param;
+        case in_type::IN_SET:  return execute_set_param;
+    }
+    // Unused opcodes decode to an empty Instruction and behave like NOP.
+    return execute_nop;
+}
+
+void cpu_dispatch_init() {
+    for (uint16_t op = 0; op < 256; op++) {
+        Instruction inst = decode(static_cast<uint8_t>(op), false);
+        dispatch_table[op] = op_entry{handler_for(inst.type), inst, instruction_length(inst)};
+
+        Instruction cb = decode(static_cast<uint8_t>(op), true);
+        dispatch_table[CB_OPCODE_BASE + op] = op_entry{handler_for(cb.type), cb, instruction_length(cb, true)};
+    }
+
+    cpu_dispatch_specialize();
+}
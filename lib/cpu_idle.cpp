@@ -0,0 +1,205 @@
+#include "cpu_idle.h"
+#include "cpu.h"
+#include "cpu_dispatch.h"
+#include "bus.h"
+#include "cart.h"
+#include "dma.h"
+#include "emu.h"
+#include "interrupt.h"
+#include "ppu.h"
+#include <algorithm>
+#include <cstdint>
+
+// Longest loop body considered, in bytes and instructions.
+static constexpr uint16_t IDLE_MAX_BYTES = 16;
+static constexpr uint8_t IDLE_MAX_INSTRS = 8;
+
+// Memory reads through a register pair, checked against the current
+// registers each time the loop is armed.
+enum : uint8_t {
+    IDLE_READ_HL = 1,
+    IDLE_READ_BC = 2,
+    IDLE_READ_DE = 4,
+    IDLE_READ_C  = 8,   // LD A,(FF00+C)
+};
+
+typedef struct {
+    // The loop: straight-line body from head to the backward branch.
+    uint16_t head;
+    uint16_t branch;
+    uint16_t bank;
+    uint8_t length;     // instructions per trip, including the branch
+    uint8_t reads;      // IDLE_READ_* used by the body
+    bool valid;         // head/branch/bank describe the last loop checked
+    bool idle;          // the body passed the checks in idle_body
+
+    // State at the head after the previous trip.
+    bool armed;
+    uint8_t regs[8];    // A F B C D E H L
+    uint16_t sp;
+    uint64_t ticks;
+    uint64_t instr_count;
+} idle_loop;
+
+static idle_loop loop;
+
+// DIV/TIMA change on every tick; everything else a loop may read only
+// changes through a CPU write, an interrupt handler or a PPU/timer event.
+static bool idle_read_ok(uint16_t addr) {
+    return addr < 0xFF04 || addr > 0xFF07;
+}
+
+// Decode one instruction of a loop body. Returns false for anything that
+// writes memory, changes control flow or is otherwise not a pure poll.
+static bool idle_instruction(uint16_t pc, uint8_t &size) {
+    uint8_t op = bus_read(pc);
+    size = 1;
+
+    if (op == 0xCB) {
+        uint8_t cb = bus_read(static_cast<uint16_t>(pc + 1));
+        size = 2;
+        if (cb < 0x40 || cb >= 0x80) return false;   // only BIT b,r
+        if ((cb & 0x07) == 6) loop.reads |= IDLE_READ_HL;
+        return true;
+    }
+
+    if (op >= 0x40 && op < 0x80) {                 // LD r,r'
+        if (op >= 0x70 && op <= 0x77) return false;  // LD (HL),r and HALT
+        if ((op & 0x07) == 6) loop.reads |= IDLE_READ_HL;
+        return true;
+    }
+    if (op >= 0x80 && op < 0xC0) {                 // ALU A,r
+        if ((op & 0x07) == 6) loop.reads |= IDLE_READ_HL;
+        return true;
+    }
+
+    switch (op) {
+        case 0x00:                                  // NOP
+        case 0x07: case 0x0F: case 0x17: case 0x1F: // RLCA/RRCA/RLA/RRA
+        case 0x2F: case 0x37: case 0x3F:            // CPL/SCF/CCF
+            return true;
+        case 0x0A: loop.reads |= IDLE_READ_BC; return true;
+        case 0x1A: loop.reads |= IDLE_READ_DE; return true;
+        case 0xF2: loop.reads |= IDLE_READ_C; return true;
+        case 0xC6: case 0xCE: case 0xD6: case 0xDE: // ALU A,n
+        case 0xE6: case 0xEE: case 0xF6: case 0xFE:
+            size = 2;
+            return true;
+        case 0xF0:                                  // LDH A,(n)
+            size = 2;
+            return idle_read_ok(static_cast<uint16_t>(0xFF00 | bus_read(static_cast<uint16_t>(pc + 1))));
+        case 0xFA:                                  // LD A,(nn)
+            size = 3;
+            return idle_read_ok(static_cast<uint16_t>(bus_read(static_cast<uint16_t>(pc + 1)) |
+                                                      (bus_read(static_cast<uint16_t>(pc + 2)) << 8)));
+        default:
+            return false;
+    }
+}
+
+// The branch at loop.branch must jump back to loop.head and everything
+// between them must be a straight run of idle instructions.
+static bool idle_body() {
+    uint8_t op = bus_read(loop.branch);
+    uint16_t target;
+    if (op == 0x18 || op == 0x20 || op == 0x28 || op == 0x30 || op == 0x38) {
+        int8_t offset = static_cast<int8_t>(bus_read(static_cast<uint16_t>(loop.branch + 1)));
+        target = static_cast<uint16_t>(loop.branch + 2 + offset);
+    } else if (op == 0xC3 || op == 0xC2 || op == 0xCA || op == 0xD2 || op == 0xDA) {
+        target = static_cast<uint16_t>(bus_read(static_cast<uint16_t>(loop.branch + 1)) |
+                                       (bus_read(static_cast<uint16_t>(loop.branch + 2)) << 8));
+    } else {
+        return false;
+    }
+    if (target != loop.head) {
+        return false;
+    }
+
+    uint16_t pc = loop.head;
+    loop.length = 1;
+    loop.reads = 0;
+    while (pc < loop.branch) {
+        uint8_t size;
+        if (loop.length == IDLE_MAX_INSTRS || !idle_instruction(pc, size)) {
+            return false;
+        }
+        pc = static_cast<uint16_t>(pc + size);
+        loop.length++;
+    }
+    return pc == loop.branch;
+}
+
+static bool idle_reads_ok() {
+    return (!(loop.reads & IDLE_READ_HL) || idle_read_ok(cpu.HL)) &&
+           (!(loop.reads & IDLE_READ_BC) || idle_read_ok(cpu.BC)) &&
+           (!(loop.reads & IDLE_READ_DE) || idle_read_ok(cpu.DE)) &&
+           (!(loop.reads & IDLE_READ_C) || idle_read_ok(static_cast<uint16_t>(0xFF00 | cpu.C)));
+}
+
+static void idle_snapshot(uint8_t *regs) {
+    regs[0] = cpu.A;
+    regs[1] = cpu_flags();
+    regs[2] = cpu.B;
+    regs[3] = cpu.C;
+    regs[4] = cpu.D;
+    regs[5] = cpu.E;
+    regs[6] = cpu.H;
+    regs[7] = cpu.L;
+}
+
+uint32_t cpu_idle_skip(uint32_t budget) {
+    uint16_t head = cpu.PC;
+    uint16_t branch = cpu.last_opcode_pc;
+
+    // Only ROM loops: their bytes cannot change under us without a bank switch.
+    if (branch >= 0x8000 || branch < head || branch - head > IDLE_MAX_BYTES) {
+        loop.armed = false;
+        return 0;
+    }
+
+    uint16_t bank = cart_rom_bank(head);
+    if (!loop.valid || loop.head != head || loop.branch != branch || loop.bank != bank) {
+        loop.valid = true;
+        loop.head = head;
+        loop.branch = branch;
+        loop.bank = bank;
+        loop.armed = false;
+        loop.idle = idle_body();
+    }
+    if (!loop.idle) {
+        return 0;
+    }
+
+    uint8_t regs[8];
+    idle_snapshot(regs);
+
+    // The last trip repeats exactly if it ran the body once with nothing in
+    // between (an interrupt handler would add instructions), ended with the
+    // same registers it started with, and nothing can interrupt the next one.
+    bool repeats = loop.armed &&
+                   cpu.instr_count - loop.instr_count == loop.length &&
+                   std::equal(regs, regs + 8, loop.regs) && cpu.SP == loop.sp &&
+                   !cpu.halt && !cpu.ime_pending && !cpu.enabling_ime &&
+                   !(cpu.ime && interrupts_pending) &&
+                   !dma_transferring() && idle_reads_ok();
+
+    uint32_t skip = 0;
+    if (repeats) {
+        uint32_t trip = static_cast<uint32_t>(sched.now - loop.ticks);
+        // A poll of LY or STAT sees the PPU's next change even without an event.
+        uint32_t next_event = ppu_cycles_to_next_change(sched_cycles_to_next_event(budget));
+        uint32_t trips = next_event ? (next_event - 1) / trip : 0;
+        skip = trips * trip;
+        if (skip) {
+            emu_cycles(static_cast<int>(skip));
+            cpu.instr_count += static_cast<uint64_t>(trips) * loop.length;
+        }
+    }
+
+    std::copy(regs, regs + 8, loop.regs);
+    loop.sp = cpu.SP;
+    loop.ticks = sched.now;
+    loop.instr_count = cpu.instr_count;
+    loop.armed = true;
+    return skip;
+}
@@ -268,4 +268,29 @@ Instruction decode(uint8_t opcode, bool is_cb) {
     }
 
     return kInstrTable[opcode];
-}
\ No newline at end of file
+}
+
+uint8_t instruction_length(const Instruction &inst, bool is_cb) {
+    if (is_cb) {
+        return 2;
+    }
+
+    switch (inst.mode) {
+        case addr_mode::REG16_IMM16:
+        case addr_mode::MEM_IMM16_REG16:
+        case addr_mode::MEM_IMM16_REG8:
+        case addr_mode::REG8_MEM_IMM16:
+        case addr_mode::ABS16:
+            return 3;
+        case addr_mode::REG8_IMM8:
+        case addr_mode::REG16_IMM8:
+        case addr_mode::MEM_REG16_IMM8:
+        case addr_mode::REG16_SP_IMM8:
+        case addr_mode::MEM_FF00_IMM8_REG8:
+        case addr_mode::REG8_MEM_FF00_IMM8:
+        case addr_mode::REL8:
+            return 2;
+        default:
+            return 1;
+    }
+}
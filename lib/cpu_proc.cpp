@@ -14,12 +14,12 @@
 #include <iomanip>
 #include "ram.h"
 
-uint8_t execute_nop(Instruction) {
+uint8_t execute_nop(const Instruction&) {
     // NOP does nothing
     return 4;
 }
 
-uint8_t execute_ld(Instruction inst) {
+uint8_t execute_ld(const Instruction& inst) {
     switch (inst.mode) {
         case addr_mode::REG16_IMM16: {
             write_reg16(inst.reg_1, fetch16());
@@ -53,15 +53,16 @@ uint8_t execute_ld(Instruction inst) {
             int8_t offset = static_cast<int8_t>(fetch8());
             uint16_t result = static_cast<uint16_t>(static_cast<int32_t>(sp) + static_cast<int32_t>(offset));
 
-            cpu.F = 0;
+            uint8_t f = 0;
             uint8_t sp_lo = static_cast<uint8_t>(sp & 0x00FF);
             uint8_t off_u = static_cast<uint8_t>(offset);
             if (((sp_lo & 0x0F) + (off_u & 0x0F)) > 0x0F) {
-                cpu.F |= FLAG_H;
+                f |= FLAG_H;
             }
             if (static_cast<uint16_t>(sp_lo) + static_cast<uint16_t>(off_u) > 0xFF) {
-                cpu.F |= FLAG_C;
+                f |= FLAG_C;
             }
+            cpu_set_flags(f);
 
             write_reg16(inst.reg_1, result);
             return 12;
@@ -141,7 +142,7 @@ uint8_t execute_ld(Instruction inst) {
     }
 }
 
-uint8_t execute_inc(Instruction inst) {
+uint8_t execute_inc(const Instruction& inst) {
     switch (inst.mode) {
         case addr_mode::REG16: {
             uint16_t reg_value = read_reg16(inst.reg_1);
@@ -155,20 +156,7 @@ uint8_t execute_inc(Instruction inst) {
             write_reg8(inst.reg_1, result);
 
             // INC r: Z set if result == 0, N reset, H from bit 3 carry, C preserved
-            uint8_t f = cpu.F & FLAG_C; // preserve carry only
-            if (result == 0) {
-                f |= FLAG_Z;
-            } else {
-                // Explicitly clear Z if result != 0
-                f &= ~FLAG_Z;
-            }
-            if (is_half_carry_add(reg_value, 1)) {
-                f |= FLAG_H;
-            } else {
-                f &= ~FLAG_H;
-            }
-            // N is 0 for INC (already clear from f &= FLAG_C above)
-            cpu.F = f;
+            cpu_flags_inc(reg_value, result);
             return 4;
         }
         case addr_mode::MEM_REG16: {
@@ -178,14 +166,7 @@ uint8_t execute_inc(Instruction inst) {
             bus_write(addr, result);
 
             // INC (HL): same flags as INC r
-            uint8_t f = cpu.F & FLAG_C; // preserve carry only
-            if (result == 0) {
-                f |= FLAG_Z;
-            }
-            if (is_half_carry_add(value, 1)) {
-                f |= FLAG_H;
-            }
-            cpu.F = f;
+            cpu_flags_inc(value, result);
             return 12;
         }
         default: {
@@ -195,7 +176,7 @@ uint8_t execute_inc(Instruction inst) {
     }
 }
 
-uint8_t execute_dec(Instruction inst) {
+uint8_t execute_dec(const Instruction& inst) {
     switch (inst.mode) {
         case addr_mode::REG16: {
             uint16_t reg_value = read_reg16(inst.reg_1);
@@ -208,19 +189,7 @@ uint8_t execute_dec(Instruction inst) {
             uint8_t result = static_cast<uint8_t>(reg_value - 1);
 
             // DEC r: Z set if result == 0, N set, H from borrow on bit 4, C preserved
-            uint8_t f = cpu.F & FLAG_C; // preserve carry only
-            if (result == 0) {
-                f |= FLAG_Z;
-            } else {
-                f &= ~FLAG_Z; // Explicitly clear Z if result != 0
-            }
-            if (is_half_carry_sub(reg_value, 1)) {
-                f |= FLAG_H;
-            } else {
-                f &= ~FLAG_H; // Explicitly clear H if no half-carry
-            }
-            f |= FLAG_N;
-            cpu.F = f;
+            cpu_flags_dec(reg_value, result);
             write_reg8(inst.reg_1, result);
             
             return 4;
@@ -232,15 +201,7 @@ uint8_t execute_dec(Instruction inst) {
             bus_write(addr, result);
 
             // DEC (HL): same flags as DEC r
-            uint8_t f = cpu.F & FLAG_C; // preserve carry only
-            if (result == 0) {
-                f |= FLAG_Z;
-            }
-            if (is_half_carry_sub(value, 1)) {
-                f |= FLAG_H;
-            }
-            f |= FLAG_N;
-            cpu.F = f;
+            cpu_flags_dec(value, result);
             return 12;
         }
         default: {
@@ -250,7 +211,7 @@ uint8_t execute_dec(Instruction inst) {
     }
 }
 
-uint8_t execute_add(Instruction inst) {
+uint8_t execute_add(const Instruction& inst) {
     switch (inst.mode) {
         case addr_mode::REG16_REG16: {
             uint16_t reg_value_1 = read_reg16(inst.reg_1);
@@ -259,7 +220,7 @@ uint8_t execute_add(Instruction inst) {
             write_reg16(inst.reg_1, result);
 
             // ADD HL,rr: N reset, H from bit 11 carry, C from bit 15 carry, Z unaffected
-            uint8_t f = cpu.F & FLAG_Z; // preserve Z only
+            uint8_t f = cpu_flags() & FLAG_Z; // preserve Z only
             f &= ~FLAG_N;
             if (is_half_carry_add16_12(reg_value_1, reg_value_2)) {
                 f |= FLAG_H;
@@ -267,7 +228,7 @@ uint8_t execute_add(Instruction inst) {
             if (is_carry_add16(reg_value_1, reg_value_2)) {
                 f |= FLAG_C;
             }
-            cpu.F = f;
+            cpu_set_flags(f);
             return 8;
         }
         case addr_mode::REG16_IMM8: {
@@ -280,14 +241,15 @@ uint8_t execute_add(Instruction inst) {
             uint16_t sp = read_reg16(inst.reg_1); // expected SP
             uint16_t result = static_cast<uint16_t>(static_cast<int32_t>(sp) + static_cast<int32_t>(imm));
 
-            cpu.F = 0;
+            uint8_t f = 0;
             uint16_t uimm = static_cast<uint16_t>(static_cast<int16_t>(imm)) & 0x00FF;
             if (((sp & 0x000F) + (uimm & 0x000F)) > 0x000F) {
-                cpu.F |= FLAG_H;
+                f |= FLAG_H;
             }
             if (((sp & 0x00FF) + (uimm & 0x00FF)) > 0x00FF) {
-                cpu.F |= FLAG_C;
+                f |= FLAG_C;
             }
+            cpu_set_flags(f);
 
             write_reg16(inst.reg_1, result);
             return 16;
@@ -295,60 +257,30 @@ uint8_t execute_add(Instruction inst) {
         case addr_mode::REG8_REG8: {
             uint8_t reg_value_1 = read_reg8(inst.reg_1);
             uint8_t reg_value_2 = read_reg8(inst.reg_2);
-            uint8_t result = reg_value_1 + reg_value_2;
-            write_reg8(inst.reg_1, result);
+            uint16_t result = static_cast<uint16_t>(reg_value_1 + reg_value_2);
+            write_reg8(inst.reg_1, static_cast<uint8_t>(result));
 
             // 8-bit ADD: Z from result, N reset, H/C from carry, other flags cleared
-            uint8_t f = 0;
-            if (result == 0) {
-                f |= FLAG_Z;
-            }
-            if (is_half_carry_add(reg_value_1, reg_value_2)) {
-                f |= FLAG_H;
-            }
-            if (is_carry_add(reg_value_1, reg_value_2)) {
-                f |= FLAG_C;
-            }
-            cpu.F = f;
+            cpu_flags_add(reg_value_1, reg_value_2, result);
             return 4;
         }
         case addr_mode::REG8_MEM_REG16: {
             uint8_t reg_value = read_reg8(inst.reg_1);
             uint16_t addr = read_reg16(inst.reg_2);
             uint8_t value = bus_read(addr);
-            uint8_t result = reg_value + value;
-            write_reg8(inst.reg_1, result);
+            uint16_t result = static_cast<uint16_t>(reg_value + value);
+            write_reg8(inst.reg_1, static_cast<uint8_t>(result));
 
-            uint8_t f = 0;
-            if (result == 0) {
-                f |= FLAG_Z;
-            }
-            if (is_half_carry_add(reg_value, value)) {
-                f |= FLAG_H;
-            }
-            if (is_carry_add(reg_value, value)) {
-                f |= FLAG_C;
-            }
-            cpu.F = f;
+            cpu_flags_add(reg_value, value, result);
             return 8;
         }
         case addr_mode::REG8_IMM8: {
             uint8_t reg_value = read_reg8(inst.reg_1);
             uint8_t imm = fetch8();
-            uint8_t result = reg_value + imm;
-            write_reg8(inst.reg_1, result);
+            uint16_t result = static_cast<uint16_t>(reg_value + imm);
+            write_reg8(inst.reg_1, static_cast<uint8_t>(result));
 
-            uint8_t f = 0;
-            if (result == 0) {
-                f |= FLAG_Z;
-            }
-            if (is_half_carry_add(reg_value, imm)) {
-                f |= FLAG_H;
-            }
-            if (is_carry_add(reg_value, imm)) {
-                f |= FLAG_C;
-            }
-            cpu.F = f;
+            cpu_flags_add(reg_value, imm, result);
             return 8;
         }
         default: {
@@ -358,65 +290,35 @@ uint8_t execute_add(Instruction inst) {
     }
 }
 
-uint8_t execute_sub(Instruction inst) {
+uint8_t execute_sub(const Instruction& inst) {
     switch (inst.mode) {
         case addr_mode::REG8_REG8: {
             uint8_t reg_value_1 = read_reg8(inst.reg_1);
             uint8_t reg_value_2 = read_reg8(inst.reg_2);
-            uint8_t result = reg_value_1 - reg_value_2;
-            write_reg8(inst.reg_1, result);
+            uint16_t result = static_cast<uint16_t>(reg_value_1 - reg_value_2);
+            write_reg8(inst.reg_1, static_cast<uint8_t>(result));
 
             // 8-bit SUB: Z from result, N set, H/C from borrow, all from scratch
-            uint8_t f = FLAG_N;
-            if (result == 0) {
-                f |= FLAG_Z;
-            }
-            if (is_half_carry_sub(reg_value_1, reg_value_2)) {
-                f |= FLAG_H;
-            }
-            if (is_carry_sub(reg_value_1, reg_value_2)) {
-                f |= FLAG_C;
-            }
-            cpu.F = f;
+            cpu_flags_sub(reg_value_1, reg_value_2, result);
             return 4;
         }
         case addr_mode::REG8_IMM8: {
             uint8_t reg_value = read_reg8(inst.reg_1);
             uint8_t imm = fetch8();
-            uint8_t result = reg_value - imm;
-            write_reg8(inst.reg_1, result);
+            uint16_t result = static_cast<uint16_t>(reg_value - imm);
+            write_reg8(inst.reg_1, static_cast<uint8_t>(result));
 
-            uint8_t f = FLAG_N;
-            if (result == 0) {
-                f |= FLAG_Z;
-            }
-            if (is_half_carry_sub(reg_value, imm)) {
-                f |= FLAG_H;
-            }
-            if (is_carry_sub(reg_value, imm)) {
-                f |= FLAG_C;
-            }
-            cpu.F = f;
+            cpu_flags_sub(reg_value, imm, result);
             return 8;
         }
         case addr_mode::REG8_MEM_REG16: {
             uint8_t reg_value = read_reg8(inst.reg_1);
             uint16_t addr = read_reg16(inst.reg_2);
             uint8_t value = bus_read(addr);
-            uint8_t result = reg_value - value;
-            write_reg8(inst.reg_1, result);
+            uint16_t result = static_cast<uint16_t>(reg_value - value);
+            write_reg8(inst.reg_1, static_cast<uint8_t>(result));
 
-            uint8_t f = FLAG_N;
-            if (result == 0) {
-                f |= FLAG_Z;
-            }
-            if (is_half_carry_sub(reg_value, value)) {
-                f |= FLAG_H;
-            }
-            if (is_carry_sub(reg_value, value)) {
-                f |= FLAG_C;
-            }
-            cpu.F = f;
+            cpu_flags_sub(reg_value, value, result);
             return 8;
         }
         default: {
@@ -426,7 +328,7 @@ uint8_t execute_sub(Instruction inst) {
     }
 }
 
-uint8_t execute_adc(Instruction inst) {
+uint8_t execute_adc(const Instruction& inst) {
     uint8_t src = 0;
     uint8_t cycles = 0;
     switch (inst.mode) {
@@ -447,19 +349,16 @@ uint8_t execute_adc(Instruction inst) {
     }
     
     uint8_t a = cpu.A;
-    bool carry_in = (cpu.F & FLAG_C) != 0;
+    bool carry_in = cpu_flag_c();
     uint16_t result = static_cast<uint16_t>(a) + static_cast<uint16_t>(src) + (carry_in ? 1 : 0);
     cpu.A = static_cast<uint8_t>(result & 0xFF);
     
-    cpu.F = 0;
-    if (cpu.A == 0) cpu.F |= FLAG_Z;
-    if (((a & 0x0F) + (src & 0x0F) + (carry_in ? 1 : 0)) > 0x0F) cpu.F |= FLAG_H;
-    if (result > 0xFF) cpu.F |= FLAG_C;
+    cpu_flags_add(a, src, result);
 
     return cycles;
 }
 
-uint8_t execute_sbc(Instruction inst) {
+uint8_t execute_sbc(const Instruction& inst) {
     uint8_t src = 0;
     uint8_t cycles = 0;
     switch (inst.mode) {
@@ -480,19 +379,16 @@ uint8_t execute_sbc(Instruction inst) {
     }
     
     uint8_t a = cpu.A;
-    bool carry_in = (cpu.F & FLAG_C) != 0;
+    bool carry_in = cpu_flag_c();
     int result = static_cast<int>(a) - static_cast<int>(src) - (carry_in ? 1 : 0);
     cpu.A = static_cast<uint8_t>(result & 0xFF);
     
-    cpu.F = FLAG_N;
-    if (cpu.A == 0) cpu.F |= FLAG_Z;
-    if (((a & 0x0F) - (src & 0x0F) - (carry_in ? 1 : 0)) < 0) cpu.F |= FLAG_H;
-    if (result < 0) cpu.F |= FLAG_C;
+    cpu_flags_sub(a, src, static_cast<uint16_t>(result));
 
     return cycles;
 }
 
-uint8_t execute_and(Instruction inst) {
+uint8_t execute_and(const Instruction& inst) {
     uint8_t src = 0;
     uint8_t cycles = 0;
     switch (inst.mode) {
@@ -513,13 +409,12 @@ uint8_t execute_and(Instruction inst) {
     }
     
     cpu.A &= src;
-    cpu.F = FLAG_H;
-    if (cpu.A == 0) cpu.F |= FLAG_Z;
+    cpu_flags_logic(cpu.A, FLAG_H);
 
     return cycles;
 }
 
-uint8_t execute_xor(Instruction inst) {
+uint8_t execute_xor(const Instruction& inst) {
     uint8_t src = 0;
     uint8_t cycles = 0;
     switch (inst.mode) {
@@ -540,13 +435,12 @@ uint8_t execute_xor(Instruction inst) {
     }
     
     cpu.A ^= src;
-    cpu.F = 0;
-    if (cpu.A == 0) cpu.F |= FLAG_Z;
+    cpu_flags_logic(cpu.A, 0);
 
     return cycles;
 }
 
-uint8_t execute_or(Instruction inst) {
+uint8_t execute_or(const Instruction& inst) {
     uint8_t src = 0;
     uint8_t cycles = 0;
     switch (inst.mode) {
@@ -567,13 +461,12 @@ uint8_t execute_or(Instruction inst) {
     }
     
     cpu.A |= src;
-    cpu.F = 0;
-    if (cpu.A == 0) cpu.F |= FLAG_Z;
+    cpu_flags_logic(cpu.A, 0);
 
     return cycles;
 }
 
-uint8_t execute_cp(Instruction inst) {
+uint8_t execute_cp(const Instruction& inst) {
     uint8_t src = 0;
     uint8_t cycles = 0;
     switch (inst.mode) {
@@ -594,140 +487,90 @@ uint8_t execute_cp(Instruction inst) {
     }
     
     uint8_t a = cpu.A;
-    uint8_t result = a - src;
+    uint16_t result = static_cast<uint16_t>(a - src);
     
-    cpu.F = FLAG_N;
-    if (result == 0) cpu.F |= FLAG_Z;
-    if ((a & 0x0F) < (src & 0x0F)) cpu.F |= FLAG_H;
-    if (a < src) cpu.F |= FLAG_C;
+    cpu_flags_sub(a, src, result);
 
     return cycles;
 }
 
-uint8_t execute_ldh(Instruction inst) {
+uint8_t execute_ldh(const Instruction& inst) {
     // LDH is handled as LD with MEM_FF00 modes
     return execute_ld(inst);
 }
 
-uint8_t execute_rlca(Instruction) {
+uint8_t execute_rlca(const Instruction&) {
     uint8_t a = cpu.A;
     uint8_t c = (a >> 7) & 1;
 
     cpu.A = (a << 1) | c;
 
-    cpu.F = 0;
-
-    if (c) {
-        cpu.F |= FLAG_C;
-    }
+    cpu_set_flags(c ? FLAG_C : 0);
     return 4;
 }
 
-uint8_t execute_rrca(Instruction) {
+uint8_t execute_rrca(const Instruction&) {
     uint8_t a = cpu.A;
     uint8_t c = a & 1;
 
     cpu.A = (a >> 1) | (c << 7);
 
-    cpu.F = 0;
-
-    if (c) {
-        cpu.F |= FLAG_C;
-    }
+    cpu_set_flags(c ? FLAG_C : 0);
     return 4;
 }
 
-uint8_t execute_rla(Instruction) {
+uint8_t execute_rla(const Instruction&) {
     uint8_t a = cpu.A;
-    uint8_t old_c = (cpu.F & FLAG_C) ? 1 : 0;
+    uint8_t old_c = cpu_flag_c() ? 1 : 0;
     uint8_t new_c = (a >> 7) & 1;
 
     cpu.A = (a << 1) | old_c;
 
-    cpu.F = 0;
-
-    if (new_c) {
-        cpu.F |= FLAG_C;
-    }
+    cpu_set_flags(new_c ? FLAG_C : 0);
     return 4;
 }
 
-uint8_t execute_rra(Instruction) {
+uint8_t execute_rra(const Instruction&) {
     uint8_t a = cpu.A;
-    uint8_t old_c = (cpu.F & FLAG_C) ? 1 : 0;
+    uint8_t old_c = cpu_flag_c() ? 1 : 0;
     uint8_t new_c = a & 1;
 
     cpu.A = (a >> 1) | (old_c << 7);
 
-    cpu.F = 0;
-
-    if (new_c) {
-        cpu.F |= FLAG_C;
-    }
+    cpu_set_flags(new_c ? FLAG_C : 0);
     return 4;
 }
 
-uint8_t execute_daa(Instruction) {
-    uint8_t a = cpu.A;
-    uint8_t f = cpu.F;
-
-    uint8_t correction = 0;
-    bool carry_out = false;
-
-    const bool n = (f & FLAG_N) != 0;
-    const bool h = (f & FLAG_H) != 0;
-    const bool c = (f & FLAG_C) != 0;
-
-    if (!n) {
-        if (h || (a & 0x0F) > 9) {
-            correction |= 0x06;
-        }
-        if (c || a > 0x99) {
-            correction |= 0x60;
-            carry_out = true;
-        }
-        a = static_cast<uint8_t>(a + correction);
-    } else {
-        if (h) correction |= 0x06;
-        if (c) correction |= 0x60;
-        a = static_cast<uint8_t>(a - correction);
-        carry_out = c;
-    }
-
-    cpu.A = a;
-
-    f &= FLAG_N;
-    if (a == 0) f |= FLAG_Z;
-    if (carry_out) f |= FLAG_C;
-
-    cpu.F = f;
+uint8_t execute_daa(const Instruction&) {
+    uint16_t af = alu_daa(cpu.A, cpu_flags());
+    cpu.A = static_cast<uint8_t>(af >> 8);
+    cpu_set_flags(static_cast<uint8_t>(af));
     return 4;
 }
 
-uint8_t execute_cpl(Instruction) {
+uint8_t execute_cpl(const Instruction&) {
     cpu.A = ~cpu.A;
 
-    cpu.F |= FLAG_N;
-    cpu.F |= FLAG_H;
+    cpu_set_flags(cpu_flags() | FLAG_N | FLAG_H);
     return 4;
 }
 
-uint8_t execute_scf(Instruction) {
+uint8_t execute_scf(const Instruction&) {
     // SCF: Clear N and H, preserve Z, set C
-    uint8_t z = cpu.F & FLAG_Z;
-    cpu.F = z | FLAG_C;
+    uint8_t z = cpu_flag_z() ? FLAG_Z : 0;
+    cpu_set_flags(z | FLAG_C);
     return 4;
 }
 
-uint8_t execute_ccf(Instruction) {
+uint8_t execute_ccf(const Instruction&) {
     // CCF: Clear N and H, preserve Z, toggle C
-    uint8_t z = cpu.F & FLAG_Z;
-    uint8_t c = (~cpu.F) & FLAG_C;
-    cpu.F = z | c;
+    uint8_t z = cpu_flag_z() ? FLAG_Z : 0;
+    uint8_t c = cpu_flag_c() ? 0 : FLAG_C;
+    cpu_set_flags(z | c);
     return 4;
 }
 
-uint8_t execute_jr(Instruction inst) {
+uint8_t execute_jr(const Instruction& inst) {
     int8_t offset = fetch8();
     uint8_t cycles = 8;
     switch (inst.cond) {
@@ -736,28 +579,28 @@ uint8_t execute_jr(Instruction inst) {
             return 12;
         }
         case cond_type::CT_Z: {
-            if (cpu.F & FLAG_Z) {
+            if (cpu_flag_z()) {
                 cpu.PC = static_cast<uint16_t>(static_cast<int32_t>(cpu.PC) + offset);
                 cycles = 12;
             }
             return cycles;
         }
         case cond_type::CT_NZ: {
-            if (!(cpu.F & FLAG_Z)) {
+            if (!cpu_flag_z()) {
                 cpu.PC = static_cast<uint16_t>(static_cast<int32_t>(cpu.PC) + offset);
                 cycles = 12;
             }
             return cycles;
         }
         case cond_type::CT_C: {
-            if (cpu.F & FLAG_C) {
+            if (cpu_flag_c()) {
                 cpu.PC = static_cast<uint16_t>(static_cast<int32_t>(cpu.PC) + offset);
                 cycles = 12;
             }
             return cycles;
         }
         case cond_type::CT_NC: {
-            if (!(cpu.F & FLAG_C)) {
+            if (!cpu_flag_c()) {
                 cpu.PC = static_cast<uint16_t>(static_cast<int32_t>(cpu.PC) + offset);
                 cycles = 12;
             }
@@ -770,7 +613,7 @@ uint8_t execute_jr(Instruction inst) {
     }
 }
 
-uint8_t execute_jp(Instruction inst) {
+uint8_t execute_jp(const Instruction& inst) {
     bool should_jump = false;
     
     if (inst.mode == addr_mode::REG16) {
@@ -787,16 +630,16 @@ uint8_t execute_jp(Instruction inst) {
             should_jump = true;
             break;
         case cond_type::CT_Z:
-            should_jump = (cpu.F & FLAG_Z) != 0;
+            should_jump = cpu_flag_z();
             break;
         case cond_type::CT_NZ:
-            should_jump = (cpu.F & FLAG_Z) == 0;
+            should_jump = !cpu_flag_z();
             break;
         case cond_type::CT_C:
-            should_jump = (cpu.F & FLAG_C) != 0;
+            should_jump = cpu_flag_c();
             break;
         case cond_type::CT_NC:
-            should_jump = (cpu.F & FLAG_C) == 0;
+            should_jump = !cpu_flag_c();
             break;
         default:
             std::printf("Unknown condition: %d\n", static_cast<int>(inst.cond));
@@ -810,7 +653,7 @@ uint8_t execute_jp(Instruction inst) {
     return 12;
 }
 
-uint8_t execute_call(Instruction inst) {
+uint8_t execute_call(const Instruction& inst) {
     uint16_t addr = fetch16();
     bool should_call = false;
     
@@ -819,16 +662,16 @@ uint8_t execute_call(Instruction inst) {
             should_call = true;
             break;
         case cond_type::CT_Z:
-            should_call = (cpu.F & FLAG_Z) != 0;
+            should_call = cpu_flag_z();
             break;
         case cond_type::CT_NZ:
-            should_call = (cpu.F & FLAG_Z) == 0;
+            should_call = !cpu_flag_z();
             break;
         case cond_type::CT_C:
-            should_call = (cpu.F & FLAG_C) != 0;
+            should_call = cpu_flag_c();
             break;
         case cond_type::CT_NC:
-            should_call = (cpu.F & FLAG_C) == 0;
+            should_call = !cpu_flag_c();
             break;
         default:
             std::printf("Unknown condition: %d\n", static_cast<int>(inst.cond));
@@ -846,7 +689,7 @@ uint8_t execute_call(Instruction inst) {
     return 12;
 }
 
-uint8_t execute_ret(Instruction inst) {
+uint8_t execute_ret(const Instruction& inst) {
     bool should_ret = false;
     uint8_t cycles = 0;
     switch (inst.cond) {
@@ -855,16 +698,16 @@ uint8_t execute_ret(Instruction inst) {
             cycles = 16;
             break;
         case cond_type::CT_Z:
-            should_ret = (cpu.F & FLAG_Z) != 0;
+            should_ret = cpu_flag_z();
             break;
         case cond_type::CT_NZ:
-            should_ret = (cpu.F & FLAG_Z) == 0;
+            should_ret = !cpu_flag_z();
             break;
         case cond_type::CT_C:
-            should_ret = (cpu.F & FLAG_C) != 0;
+            should_ret = cpu_flag_c();
             break;
         case cond_type::CT_NC:
-            should_ret = (cpu.F & FLAG_C) == 0;
+            should_ret = !cpu_flag_c();
             break;
         default:
             return 0;
@@ -883,7 +726,7 @@ uint8_t execute_ret(Instruction inst) {
     return 8;
 }
 
-uint8_t execute_reti(Instruction) {
+uint8_t execute_reti(const Instruction&) {
     uint16_t ret_addr = bus_read16(cpu.SP);
     cpu.SP = static_cast<uint16_t>(cpu.SP + 2);
     cpu.PC = ret_addr;
@@ -891,7 +734,7 @@ uint8_t execute_reti(Instruction) {
     return 16;
 }
 
-uint8_t execute_rst(Instruction inst) {
+uint8_t execute_rst(const Instruction& inst) {
     uint8_t rst_vec = inst.param;
     uint16_t ret_addr = cpu.PC;
     cpu.SP = static_cast<uint16_t>(cpu.SP - 2);
@@ -900,46 +743,46 @@ uint8_t execute_rst(Instruction inst) {
     return 16;
 }
 
-uint8_t execute_push(Instruction inst) {
+uint8_t execute_push(const Instruction& inst) {
     uint16_t reg_value = read_reg16(inst.reg_1);
     stack_push16(reg_value);
     return 16;
 }
 
-uint8_t execute_pop(Instruction inst) {
+uint8_t execute_pop(const Instruction& inst) {
     uint16_t reg_value = stack_pop16();
     
     write_reg16(inst.reg_1, reg_value);
 
     if (inst.reg_1 == reg_type::AF) {
-        cpu.F = cpu.F & 0xF0;
+        cpu_set_flags(cpu_flags() & 0xF0);
     }
     
     return 12;
 }
 
-uint8_t execute_halt(Instruction) {
+uint8_t execute_halt(const Instruction&) {
     cpu.halt = true;
     return 4;
 }
-uint8_t execute_stop(Instruction) {
+uint8_t execute_stop(const Instruction&) {
     cpu.stop = true;
     timer_write_div();
     return 4;
 }
-uint8_t execute_di(Instruction) {
+uint8_t execute_di(const Instruction&) {
     cpu.ime = false;
     cpu.enabling_ime = false;  // Clear any pending EI
     return 4;
 }
-uint8_t execute_ei(Instruction) {
+uint8_t execute_ei(const Instruction&) {
     // EI delays IME enabling by one instruction (LLD's behavior)
     // Set flag to enable IME on the next instruction
     cpu.enabling_ime = true;
     return 4;
 }
 
-uint8_t execute_rlc(Instruction inst) {
+uint8_t execute_rlc(const Instruction& inst) {
     switch (inst.mode) {
         case addr_mode::REG8: {
             uint8_t a = read_reg8(inst.reg_1);
@@ -956,7 +799,7 @@ uint8_t execute_rlc(Instruction inst) {
                 f |= FLAG_Z;
             }
 
-            cpu.F = f;
+            cpu_set_flags(f);
             return 8;
         }
         case addr_mode::MEM_REG16: {
@@ -975,7 +818,7 @@ uint8_t execute_rlc(Instruction inst) {
                 f |= FLAG_Z;
             }
 
-            cpu.F = f;
+            cpu_set_flags(f);
             return 16;
         }
         default: {
@@ -985,7 +828,7 @@ uint8_t execute_rlc(Instruction inst) {
     }
 }
 
-uint8_t execute_rrc(Instruction inst) {
+uint8_t execute_rrc(const Instruction& inst) {
     switch (inst.mode) {
         case addr_mode::REG8: {
             uint8_t a = read_reg8(inst.reg_1);
@@ -1002,7 +845,7 @@ uint8_t execute_rrc(Instruction inst) {
                 f |= FLAG_Z;
             }
 
-            cpu.F = f;
+            cpu_set_flags(f);
             return 8;
         }
         case addr_mode::MEM_REG16: {
@@ -1021,7 +864,7 @@ uint8_t execute_rrc(Instruction inst) {
                 f |= FLAG_Z;
             }
 
-            cpu.F = f;
+            cpu_set_flags(f);
             return 16;
         }
         default: {
@@ -1031,11 +874,11 @@ uint8_t execute_rrc(Instruction inst) {
     }
 }
 
-uint8_t execute_rl(Instruction inst) {
+uint8_t execute_rl(const Instruction& inst) {
     switch (inst.mode) {
         case addr_mode::REG8: {
             uint8_t a = read_reg8(inst.reg_1);
-            uint8_t old_c = (cpu.F & FLAG_C) ? 1 : 0;
+            uint8_t old_c = cpu_flag_c() ? 1 : 0;
             uint8_t new_c = (a >> 7) & 1;
             uint8_t result = static_cast<uint8_t>((a << 1) | old_c);
             write_reg8(inst.reg_1, result);
@@ -1049,13 +892,13 @@ uint8_t execute_rl(Instruction inst) {
                 f |= FLAG_Z;
             }
 
-            cpu.F = f;
+            cpu_set_flags(f);
             return 8;
         }
         case addr_mode::MEM_REG16: {
             uint16_t addr = read_reg16(inst.reg_1);
             uint8_t value = bus_read(addr);
-            uint8_t old_c = (cpu.F & FLAG_C) ? 1 : 0;
+            uint8_t old_c = cpu_flag_c() ? 1 : 0;
             uint8_t new_c = (value >> 7) & 1;
             uint8_t result = static_cast<uint8_t>((value << 1) | old_c);
             bus_write(addr, result);
@@ -1068,7 +911,7 @@ uint8_t execute_rl(Instruction inst) {
                 f |= FLAG_Z;
             }
 
-            cpu.F = f;
+            cpu_set_flags(f);
             return 16;
         }
         default: {
@@ -1078,11 +921,11 @@ uint8_t execute_rl(Instruction inst) {
     }
 }
 
-uint8_t execute_rr(Instruction inst) {
+uint8_t execute_rr(const Instruction& inst) {
     switch (inst.mode) {
         case addr_mode::REG8: {
             uint8_t a = read_reg8(inst.reg_1);
-            uint8_t old_c = (cpu.F & FLAG_C) ? 1 : 0;
+            uint8_t old_c = cpu_flag_c() ? 1 : 0;
             uint8_t new_c = a & 1;
             uint8_t result = static_cast<uint8_t>((a >> 1) | (old_c << 7));
             write_reg8(inst.reg_1, result);
@@ -1096,13 +939,13 @@ uint8_t execute_rr(Instruction inst) {
                 f |= FLAG_Z;
             }
 
-            cpu.F = f;
+            cpu_set_flags(f);
             return 8;
         }
         case addr_mode::MEM_REG16: {
             uint16_t addr = read_reg16(inst.reg_1);
             uint8_t value = bus_read(addr);
-            uint8_t old_c = (cpu.F & FLAG_C) ? 1 : 0;
+            uint8_t old_c = cpu_flag_c() ? 1 : 0;
             uint8_t new_c = value & 1;
             uint8_t result = static_cast<uint8_t>((value >> 1) | (old_c << 7));
             bus_write(addr, result);
@@ -1115,7 +958,7 @@ uint8_t execute_rr(Instruction inst) {
                 f |= FLAG_Z;
             }
 
-            cpu.F = f;
+            cpu_set_flags(f);
             return 16;
         }
         default: {
@@ -1125,7 +968,7 @@ uint8_t execute_rr(Instruction inst) {
     }
 }
 
-uint8_t execute_sla(Instruction inst) {
+uint8_t execute_sla(const Instruction& inst) {
     switch (inst.mode) {
         case addr_mode::REG8: {
             uint8_t a = read_reg8(inst.reg_1);
@@ -1142,7 +985,7 @@ uint8_t execute_sla(Instruction inst) {
                 f |= FLAG_Z;
             }
 
-            cpu.F = f;
+            cpu_set_flags(f);
             return 8;
         }
         case addr_mode::MEM_REG16: {
@@ -1161,7 +1004,7 @@ uint8_t execute_sla(Instruction inst) {
                 f |= FLAG_Z;
             }
 
-            cpu.F = f;
+            cpu_set_flags(f);
             return 16;
         }
         default: {
@@ -1171,7 +1014,7 @@ uint8_t execute_sla(Instruction inst) {
     }
 }
 
-uint8_t execute_sra(Instruction inst) {
+uint8_t execute_sra(const Instruction& inst) {
     switch (inst.mode) {
         case addr_mode::REG8: {
             uint8_t v = read_reg8(inst.reg_1);
@@ -1182,7 +1025,7 @@ uint8_t execute_sra(Instruction inst) {
             uint8_t f = 0;
             if (result == 0) f |= FLAG_Z;
             if (c)          f |= FLAG_C;
-            cpu.F = f;
+            cpu_set_flags(f);
             return 8;
         }
         case addr_mode::MEM_REG16: {
@@ -1195,7 +1038,7 @@ uint8_t execute_sra(Instruction inst) {
             uint8_t f = 0;
             if (result == 0) f |= FLAG_Z;
             if (c)          f |= FLAG_C;
-            cpu.F = f;
+            cpu_set_flags(f);
             return 16;
         }
         default: {
@@ -1205,7 +1048,7 @@ uint8_t execute_sra(Instruction inst) {
     }
 }
 
-uint8_t execute_swap(Instruction inst) {
+uint8_t execute_swap(const Instruction& inst) {
     switch (inst.mode) {
         case addr_mode::REG8: {
             uint8_t a = read_reg8(inst.reg_1);
@@ -1213,7 +1056,7 @@ uint8_t execute_swap(Instruction inst) {
             write_reg8(inst.reg_1, result);
             uint8_t f = 0;
             if (result == 0) f |= FLAG_Z;
-            cpu.F = f;
+            cpu_set_flags(f);
             return 8;
         }
         case addr_mode::MEM_REG16: {
@@ -1223,7 +1066,7 @@ uint8_t execute_swap(Instruction inst) {
             bus_write(addr, result);
             uint8_t f = 0;
             if (result == 0) f |= FLAG_Z;
-            cpu.F = f;
+            cpu_set_flags(f);
             return 16;
         }
         default: {
@@ -1233,7 +1076,7 @@ uint8_t execute_swap(Instruction inst) {
     }
 }
 
-uint8_t execute_srl(Instruction inst) {
+uint8_t execute_srl(const Instruction& inst) {
     switch (inst.mode) {
         case addr_mode::REG8: {
             uint8_t a = read_reg8(inst.reg_1);
@@ -1243,7 +1086,7 @@ uint8_t execute_srl(Instruction inst) {
             uint8_t f = 0;
             if (result == 0) f |= FLAG_Z;
             if (c) f |= FLAG_C;
-            cpu.F = f;
+            cpu_set_flags(f);
             return 8;
         }
         case addr_mode::MEM_REG16: {
@@ -1255,7 +1098,7 @@ uint8_t execute_srl(Instruction inst) {
             uint8_t f = 0;
             if (result == 0) f |= FLAG_Z;
             if (c) f |= FLAG_C;
-            cpu.F = f;
+            cpu_set_flags(f);
             return 16;
         }
         default: {
@@ -1273,10 +1116,10 @@ uint8_t execute_bit(const Instruction& inst, uint8_t bit_to_check) {
             uint8_t v = read_reg8(inst.reg_1);
             uint8_t test = static_cast<uint8_t>(v & mask);
 
-            uint8_t f = cpu.F & FLAG_C;
+            uint8_t f = cpu_flag_c() ? FLAG_C : 0;
             f |= FLAG_H;
             if (test == 0) f |= FLAG_Z;
-            cpu.F = f;
+            cpu_set_flags(f);
             return 8;
         }
 
@@ -1285,10 +1128,10 @@ uint8_t execute_bit(const Instruction& inst, uint8_t bit_to_check) {
             uint8_t v = bus_read(addr);
             uint8_t test = static_cast<uint8_t>(v & mask);
 
-            uint8_t f = cpu.F & FLAG_C;
+            uint8_t f = cpu_flag_c() ? FLAG_C : 0;
             f |= FLAG_H;
             if (test == 0) f |= FLAG_Z;
-            cpu.F = f;
+            cpu_set_flags(f);
             return 12;
         }
 
@@ -0,0 +1,21 @@
+#include "cpu_specialized.h"
+#include "cpu_dispatch.h"
+#include <array>
+#include <cstdint>
+#include <utility>
+
+template <std::size_t... OP>
+static constexpr std::array<op_handler, sizeof...(OP)> make_specialized_table(std::index_sequence<OP...>) {
+    return {{ specialized::handler<OP>()... }};
+}
+
+static constexpr std::array<op_handler, 512> kSpecialized =
+    make_specialized_table(std::make_index_sequence<512>{});
+
+void cpu_dispatch_specialize() {
+    for (std::size_t op = 0; op < kSpecialized.size(); op++) {
+        if (kSpecialized[op]) {
+            dispatch_table[op].handler = kSpecialized[op];
+        }
+    }
+}
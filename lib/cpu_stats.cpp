@@ -0,0 +1,124 @@
+#include "cpu_stats.h"
+
+#ifdef CPU_STATS
+
+#include "cpu_dispatch.h"
+#include <algorithm>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+static constexpr uint16_t OPCODE_COUNT = 512;
+
+// Pairs shown in the report; the full table is 256K entries.
+static constexpr size_t REPORT_PAIRS = 64;
+
+static uint64_t op_counts[OPCODE_COUNT];
+static uint64_t pair_counts[OPCODE_COUNT][OPCODE_COUNT];
+static int prev_op = -1;
+static volatile std::sig_atomic_t dump_requested = 0;
+
+static const char *const MODE_NAMES[] = {
+    "IMPLIED", "REG8", "REG16", "REG8_REG8", "REG16_REG16", "REG16_IMM16",
+    "REG8_IMM8", "REG16_IMM8", "MEM_REG16", "MEM_REG16_REG8", "MEM_REG16_IMM8",
+    "MEM_IMM16_REG16", "REG8_MEM_REG16", "MEM_HLI_REG8", "REG8_MEM_HLI",
+    "MEM_HLD_REG8", "REG8_MEM_HLD", "MEM_IMM16_REG8", "REG8_MEM_IMM16",
+    "REG16_SP_IMM8", "MEM_FF00_IMM8_REG8", "REG8_MEM_FF00_IMM8",
+    "MEM_FF00_C_REG8", "REG8_MEM_FF00_C", "REL8", "ABS16", "RST_VEC",
+};
+static constexpr size_t MODE_COUNT = sizeof(MODE_NAMES) / sizeof(MODE_NAMES[0]);
+static_assert(static_cast<size_t>(addr_mode::RST_VEC) + 1 == MODE_COUNT, "MODE_NAMES out of date");
+
+static void on_signal(int) {
+    dump_requested = 1;
+}
+
+void cpu_stats_init() {
+    std::signal(SIGUSR1, on_signal);
+}
+
+void cpu_stats_record(uint16_t op) {
+    op_counts[op]++;
+    if (prev_op >= 0) {
+        pair_counts[prev_op][op]++;
+    }
+    prev_op = op;
+}
+
+void cpu_stats_poll() {
+    if (dump_requested) {
+        dump_requested = 0;
+        cpu_stats_dump(stderr);
+    }
+}
+
+// "1A" or "CB 1A".
+static void format_op(char *buf, size_t size, uint16_t op) {
+    if (op >= CB_OPCODE_BASE) {
+        snprintf(buf, size, "CB %02X", op & 0xFF);
+    } else {
+        snprintf(buf, size, "%02X", op);
+    }
+}
+
+static double percent(uint64_t count, uint64_t total) {
+    return total ? 100.0 * static_cast<double>(count) / static_cast<double>(total) : 0.0;
+}
+
+void cpu_stats_dump(FILE *out) {
+    uint64_t total = 0;
+    uint64_t mode_counts[MODE_COUNT] = {};
+    std::vector<std::pair<uint64_t, uint16_t>> ops;
+    for (uint16_t op = 0; op < OPCODE_COUNT; op++) {
+        if (!op_counts[op]) continue;
+        total += op_counts[op];
+        mode_counts[static_cast<size_t>(dispatch_table[op].inst.mode)] += op_counts[op];
+        ops.push_back({op_counts[op], op});
+    }
+    std::sort(ops.rbegin(), ops.rend());
+
+    std::vector<std::pair<uint64_t, uint32_t>> pairs;
+    uint64_t pair_total = 0;
+    for (uint32_t first = 0; first < OPCODE_COUNT; first++) {
+        for (uint32_t second = 0; second < OPCODE_COUNT; second++) {
+            uint64_t count = pair_counts[first][second];
+            if (!count) continue;
+            pair_total += count;
+            pairs.push_back({count, first * OPCODE_COUNT + second});
+        }
+    }
+    size_t shown = std::min(pairs.size(), REPORT_PAIRS);
+    std::partial_sort(pairs.begin(), pairs.begin() + shown, pairs.end(),
+                      [](const auto &a, const auto &b) { return a.first > b.first; });
+
+    std::vector<std::pair<uint64_t, size_t>> modes;
+    for (size_t mode = 0; mode < MODE_COUNT; mode++) {
+        if (mode_counts[mode]) modes.push_back({mode_counts[mode], mode});
+    }
+    std::sort(modes.rbegin(), modes.rend());
+
+    char a[8], b[8];
+    fprintf(out, "== opcodes (%llu executed) ==\n", static_cast<unsigned long long>(total));
+    for (const auto &[count, op] : ops) {
+        format_op(a, sizeof(a), op);
+        fprintf(out, "%-6s %14llu %6.2f%%\n", a, static_cast<unsigned long long>(count), percent(count, total));
+    }
+
+    fprintf(out, "== opcode pairs (top %zu of %zu) ==\n", shown, pairs.size());
+    for (size_t i = 0; i < shown; i++) {
+        format_op(a, sizeof(a), static_cast<uint16_t>(pairs[i].second / OPCODE_COUNT));
+        format_op(b, sizeof(b), static_cast<uint16_t>(pairs[i].second % OPCODE_COUNT));
+        fprintf(out, "%-6s %-6s %14llu %6.2f%%\n", a, b,
+                static_cast<unsigned long long>(pairs[i].first), percent(pairs[i].first, pair_total));
+    }
+
+    fprintf(out, "== addressing modes ==\n");
+    for (const auto &[count, mode] : modes) {
+        fprintf(out, "%-20s %14llu %6.2f%%\n", MODE_NAMES[mode],
+                static_cast<unsigned long long>(count), percent(count, total));
+    }
+    fflush(out);
+}
+
+#endif
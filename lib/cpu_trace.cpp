@@ -0,0 +1,109 @@
+#include "cpu_trace.h"
+
+#ifdef CPU_TRACE
+
+#include "cpu.h"
+#include "bus.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+
+// Single-producer (CPU) / single-consumer (writer thread) ring. head and tail
+// count records ever written/read; only their low bits index the buffer.
+static constexpr uint32_t TRACE_RING_SIZE = 1 << 16;
+static trace_record ring[TRACE_RING_SIZE];
+static std::atomic<uint32_t> ring_head{0};
+static std::atomic<uint32_t> ring_tail{0};
+
+static std::atomic<bool> writer_stop{false};
+static std::thread writer;
+static FILE *trace_file = nullptr;
+static uint64_t record_count = 0;
+
+bool cpu_trace_enabled = false;
+
+static void writer_main() {
+    for (;;) {
+        uint32_t tail = ring_tail.load(std::memory_order_relaxed);
+        uint32_t head = ring_head.load(std::memory_order_acquire);
+
+        if (head == tail) {
+            if (writer_stop.load(std::memory_order_acquire) &&
+                ring_head.load(std::memory_order_acquire) == tail) {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        // Write up to the end of the buffer, then wrap on the next pass.
+        uint32_t start = tail & (TRACE_RING_SIZE - 1);
+        uint32_t count = head - tail;
+        if (count > TRACE_RING_SIZE - start) {
+            count = TRACE_RING_SIZE - start;
+        }
+        fwrite(&ring[start], sizeof(trace_record), count, trace_file);
+        ring_tail.store(tail + count, std::memory_order_release);
+    }
+}
+
+bool cpu_trace_start(const char *path) {
+    trace_file = fopen(path, "wb");
+    if (!trace_file) {
+        printf("Failed to open trace file: %s\n", path);
+        return false;
+    }
+    fwrite(TRACE_MAGIC, 1, sizeof(TRACE_MAGIC), trace_file);
+
+    ring_head.store(0);
+    ring_tail.store(0);
+    record_count = 0;
+    writer_stop.store(false);
+    writer = std::thread(writer_main);
+    cpu_trace_enabled = true;
+    return true;
+}
+
+void cpu_trace_stop() {
+    if (!trace_file) {
+        return;
+    }
+    cpu_trace_enabled = false;
+    writer_stop.store(true, std::memory_order_release);
+    writer.join();
+    fclose(trace_file);
+    trace_file = nullptr;
+}
+
+void cpu_trace_record(uint16_t pc) {
+    if (record_count >= TRACE_MAX_RECORDS) {
+        return;
+    }
+    record_count++;
+
+    uint32_t head = ring_head.load(std::memory_order_relaxed);
+    // Full: wait for the writer rather than drop records.
+    while (head - ring_tail.load(std::memory_order_acquire) == TRACE_RING_SIZE) {
+        std::this_thread::yield();
+    }
+
+    trace_record &rec = ring[head & (TRACE_RING_SIZE - 1)];
+    rec.A = cpu.A;
+    rec.F = cpu_flags();
+    rec.B = cpu.B;
+    rec.C = cpu.C;
+    rec.D = cpu.D;
+    rec.E = cpu.E;
+    rec.H = cpu.H;
+    rec.L = cpu.L;
+    rec.SP = cpu.SP;
+    rec.PC = pc;
+    for (int i = 0; i < 4; i++) {
+        rec.pcmem[i] = bus_read(static_cast<uint16_t>(pc + i));
+    }
+    ring_head.store(head + 1, std::memory_order_release);
+}
+
+#endif
@@ -3,92 +3,71 @@
 #include "cpu.h"
 #include "bus.h"
 #include "emu.h"
+#ifdef CPU_BLOCK_CACHE
+#include "block_cache.h"
+#endif
+#include <cstddef>
 #include <cstdint>
 
+// r8 slot for each 8-bit reg_type (A B C D E H L, in enum order).
+static constexpr uint8_t kReg8Slot[] = {
+    cpu_reg8_slot(R16_AF, true),
+    cpu_reg8_slot(R16_BC, true), cpu_reg8_slot(R16_BC, false),
+    cpu_reg8_slot(R16_DE, true), cpu_reg8_slot(R16_DE, false),
+    cpu_reg8_slot(R16_HL, true), cpu_reg8_slot(R16_HL, false),
+};
+
+// r16 slot for HL, BC, DE (in enum order).
+static constexpr uint8_t kReg16Slot[] = {R16_HL, R16_BC, R16_DE};
+
+static_assert(offsetof(cpu_state, A) == cpu_reg8_slot(R16_AF, true), "register file layout");
+static_assert(offsetof(cpu_state, L) == cpu_reg8_slot(R16_HL, false), "register file layout");
+static_assert(offsetof(cpu_state, HL) == 2 * R16_HL, "register file layout");
+
 uint8_t read_reg8(reg_type r) {
-    switch (r) {
-        case reg_type::A: return cpu.A;
-        case reg_type::B: return cpu.B;
-        case reg_type::C: return cpu.C;
-        case reg_type::D: return cpu.D;
-        case reg_type::E: return cpu.E;
-        case reg_type::H: return cpu.H;
-        case reg_type::L: return cpu.L;
-        default:
-            return 0; // Invalid for 8-bit registers
+    if (r > reg_type::L) {
+        return 0; // Invalid for 8-bit registers
     }
+    return cpu.r8[kReg8Slot[static_cast<int>(r)]];
 }
 
 void write_reg8(reg_type r, uint8_t v) {
-    switch (r) {
-        case reg_type::A: cpu.A = v; break;
-        case reg_type::B: cpu.B = v; break;
-        case reg_type::C: cpu.C = v; break;
-        case reg_type::D: cpu.D = v; break;
-        case reg_type::E: cpu.E = v; break;
-        case reg_type::H: cpu.H = v; break;
-        case reg_type::L: cpu.L = v; break;
-        default:
-            break; // Invalid for 8-bit registers
+    if (r > reg_type::L) {
+        return; // Invalid for 8-bit registers
     }
+    cpu.r8[kReg8Slot[static_cast<int>(r)]] = v;
 }
 
 uint16_t read_reg16(reg_type r) {
     switch (r) {
-        case reg_type::BC: return (static_cast<uint16_t>(cpu.B) << 8) | static_cast<uint16_t>(cpu.C);
-        case reg_type::DE: return (static_cast<uint16_t>(cpu.D) << 8) | static_cast<uint16_t>(cpu.E);
-        case reg_type::HL: return (static_cast<uint16_t>(cpu.H) << 8) | static_cast<uint16_t>(cpu.L);
-        case reg_type::SP: return static_cast<uint16_t>(cpu.SP);
-        case reg_type::AF: return (static_cast<uint16_t>(cpu.A) << 8) | static_cast<uint16_t>(cpu.F & 0xF0);
+        case reg_type::HL:
+        case reg_type::BC:
+        case reg_type::DE:
+            return cpu.r16[kReg16Slot[static_cast<int>(r) - static_cast<int>(reg_type::HL)]];
+        case reg_type::SP: return cpu.SP;
+        case reg_type::AF: return static_cast<uint16_t>((cpu.A << 8) | (cpu_flags() & 0xF0));
         default:
             return 0; // Invalid for 16-bit registers
     }
 }
+
 void write_reg16(reg_type r, uint16_t v) {
     switch (r) {
-        case reg_type::BC: cpu.B = static_cast<uint8_t>(v >> 8); cpu.C = static_cast<uint8_t>(v & 0xFF); break;
-        case reg_type::DE: cpu.D = static_cast<uint8_t>(v >> 8); cpu.E = static_cast<uint8_t>(v & 0xFF); break;
-        case reg_type::HL: cpu.H = static_cast<uint8_t>(v >> 8); cpu.L = static_cast<uint8_t>(v & 0xFF); break;
-        case reg_type::SP: cpu.SP = static_cast<uint16_t>(v); break;
+        case reg_type::HL:
+        case reg_type::BC:
+        case reg_type::DE:
+            cpu.r16[kReg16Slot[static_cast<int>(r) - static_cast<int>(reg_type::HL)]] = v;
+            break;
+        case reg_type::SP: cpu.SP = v; break;
         case reg_type::AF:
             cpu.A = static_cast<uint8_t>(v >> 8);
-            cpu.F = static_cast<uint8_t>(v & 0xF0); // Lower nibble always 0
+            cpu_set_flags(static_cast<uint8_t>(v & 0xF0)); // Lower nibble always 0
             break;
         default:
             break; // Invalid for 16-bit registers
     }
 }
 
-uint8_t fetch8() {
-    uint8_t value = bus_read(cpu.PC);
-    cpu.PC = static_cast<uint16_t>(cpu.PC + 1);
-    return value;
-}
-
-uint16_t fetch16() {
-    uint8_t lo = bus_read(cpu.PC);
-    cpu.PC = static_cast<uint16_t>(cpu.PC + 1);
-    uint8_t hi = bus_read(cpu.PC);
-    cpu.PC = static_cast<uint16_t>(cpu.PC + 1);
-    return (static_cast<uint16_t>(hi) << 8) | static_cast<uint16_t>(lo);
-}
-
-bool is_carry_add(uint8_t a, uint8_t b) {
-    return (uint16_t)a + (uint16_t)b > 0xFF;
-}
-
-bool is_half_carry_add(uint8_t a, uint8_t b) {
-    return ((a & 0x0F) + (b & 0x0F)) > 0x0F;
-}
-
-bool is_carry_sub(uint8_t a, uint8_t b) {
-    return a < b;
-}
-
-bool is_half_carry_sub(uint8_t a, uint8_t b) {
-    return (a & 0x0F) < (b & 0x0F);
-}
-
 // 16-bit helpers for operations like ADD HL,rr.
 bool is_carry_add16(uint16_t a, uint16_t b) {
     return static_cast<uint32_t>(a) + static_cast<uint32_t>(b) > 0xFFFFu;
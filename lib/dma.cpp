@@ -1,41 +1,67 @@
 #include "dma.h"
 #include "ppu.h"
 #include "bus.h"
+#include "ram.h"
+#include "scheduler.h"
+#ifdef CPU_BLOCK_CACHE
+#include "block_cache.h"
+#endif
 #include <cstdio>
 #include <cstdint>
+#include <cstring>
 #include <unistd.h>
 
+// Two M-cycles of setup, then one byte per M-cycle.
+static constexpr uint32_t DMA_START_DELAY = 2 * 4;
+static constexpr uint32_t DMA_BYTES = 0xA0;
+
 struct dma_context {
     bool active;
-    uint8_t byte;
-    uint8_t value;
-    uint8_t start_delay;
+    uint64_t done;              // sched.now the last byte lands
+    uint8_t source[DMA_BYTES];  // the source page, read when the transfer starts
 };
 
 static dma_context ctx;
 
 void dma_start(uint8_t start) {
-    ctx.active = true;
-    ctx.byte = 0;
-    ctx.start_delay = 2;
-    ctx.value = start;
-}
-
-void dma_tick() {
-    if (!ctx.active) {
-        return;
+    // The CPU is locked out of the source for the whole transfer, so reading
+    // it all now gives the bytes the transfer would have read one at a time.
+    // A restart during a transfer reads through the normal mapping, not the
+    // locked one.
+    if (ctx.active) {
+        bus_dma_lock(false);
     }
-
-    if (ctx.start_delay) {
-        ctx.start_delay--;
-        return;
+    uint16_t base = static_cast<uint16_t>(start << 8);
+    const uint8_t *page = bus_pages.read[start];
+    if (page) {
+        memcpy(ctx.source, page, DMA_BYTES);
+    } else {
+        for (uint16_t i = 0; i < DMA_BYTES; i++) {
+            ctx.source[i] = bus_read(static_cast<uint16_t>(base + i));
+        }
     }
+    ctx.active = true;
 
-    ppu_oam_write(ctx.byte, bus_read((ctx.value * 0x100) + ctx.byte));
-
-    ctx.byte++;
+    // Bytes land on M-cycle boundaries; the last one is written on the
+    // boundary DMA_START_DELAY + 159 M-cycles after the first one following
+    // the write.
+    uint64_t first = (sched.now / 4 + 1) * 4;
+    ctx.done = first + DMA_START_DELAY + (DMA_BYTES - 1) * 4;
+    sched_set(EV_DMA, ctx.done);
+    bus_dma_lock(true);
+#ifdef CPU_BLOCK_CACHE
+    // Cached blocks fetch from their own copy of the code; make the running
+    // one stop so the next fetch goes through the locked bus.
+    block_cache_epoch++;
+#endif
+}
 
-    ctx.active = ctx.byte < 0xA0;
+void dma_event() {
+    // Lines the PPU started before the transfer finished saw the old OAM.
+    ppu_sync_to(ctx.done - 1);
+    memcpy(ram.oam, ctx.source, DMA_BYTES);
+    ctx.active = false;
+    bus_dma_lock(false);
 }
 
 bool dma_transferring() {
@@ -1,45 +1,48 @@
 #include <cpu.h>
 #include "stack.h"
 #include "interrupt.h"
-#include "bus.h"
+#include "io.h"
+#include "ram.h"
+
+uint8_t interrupts_pending = 0;
+
+void interrupt_flags_changed() {
+    interrupts_pending = io.if_reg & ram.ie & 0x1F;
+}
 
 uint8_t cpu_handle_interrupts(cpu_state *cpu) {
-    uint8_t ie = bus_read(0xFFFF);
-    uint8_t if_reg = bus_read(0xFF0F);
+    uint8_t pending = interrupts_pending;
+    if (!pending) {
+        return 0;
+    }
 
     if (cpu->halt) {
-        if (ie & if_reg) {
-            cpu->halt = false;
-        }
+        cpu->halt = false;
     }
 
-    if (cpu->ime && (ie & if_reg)) {
-        
-        for (int i = 0; i < 5; i++) {
-            uint8_t mask = 1 << i;
-            
-            // check if ie flag is enabled
-            if ((ie & mask) && (if_reg & mask)) {
-                cpu->ime = false;
-
-                if_reg &= ~mask;
-                bus_write(0xFF0F, if_reg);
-                stack_push16(cpu->PC);
-                cpu->PC = 0x0040 + (i * 8);
-                return 20; 
-            }
+    if (cpu->ime) {
+        // Lowest bit wins: VBlank, STAT, timer, serial, joypad.
+        int i = 0;
+        while (!(pending & (1 << i))) {
+            i++;
         }
+        cpu->ime = false;
+
+        io.if_reg &= ~(1 << i);
+        interrupt_flags_changed();
+        stack_push16(cpu->PC);
+        cpu->PC = 0x0040 + (i * 8);
+        return 20;
     }
 
     return 0;
 }
 
 void request_interrupt(uint8_t type) {
-    uint8_t if_reg = bus_read(0xFF0F);
-    if_reg |= type;
-    bus_write(0xFF0F, if_reg);
+    io.if_reg |= type;
+    interrupt_flags_changed();
     
     if (cpu.halt) {
         cpu.halt = false;
     }
-}
\ No newline at end of file
+}
@@ -4,6 +4,8 @@
 #include "timer.h"
 #include "emu.h"
 #include "dma.h"
+#include "ppu.h"
+#include "scheduler.h"
 #include <cstdio>
 #include <cstdint>
 #include <cstdlib>
@@ -15,9 +17,7 @@ static uint8_t joypad_state = 0x00;  // all released
 
 void joypad_press(joypad_btn btn) {
     joypad_state |= (1 << btn);
-
-    uint8_t if_reg = io.if_reg;
-    io.if_reg = if_reg | 0x10;
+    request_interrupt(IT_JOYPAD);
 }
 
 void joypad_release(joypad_btn btn) {
@@ -76,150 +76,220 @@ void io_init() {
     io.nr50 = 0x77;
     io.nr51 = 0xF3;
     io.nr52 = 0xF1;  // DMG: bit 7 set means sound enabled
+    for (uint8_t &b : io.wave_ram) b = 0x00;
+
+    interrupt_flags_changed();
 }
 
-uint8_t io_read(uint16_t addr) {
-    if (addr == 0xFF00) {
-        // Joypad register (P1/JOYP):
-        //   Bits 7-6: unused, always 1
-        //   Bit 5: 0 = select action buttons (Start/Select/B/A)
-        //   Bit 4: 0 = select d-pad (Down/Up/Left/Right)
-        //   Bits 3-0: button state (0 = pressed, 1 = not pressed)
-        uint8_t result = 0xCF; // all unselected, no buttons
-        if (!(io.joypad & 0x10)) {
-            // D-pad selected: bits 0-3 of joypad_state = Right,Left,Up,Down
-            result = 0xC0 | (io.joypad & 0x30) | (~joypad_state & 0x0F);
-        }
-        if (!(io.joypad & 0x20)) {
-            // Action buttons selected: bits 4-7 of joypad_state = A,B,Select,Start
-            result = 0xC0 | (io.joypad & 0x30) | (~(joypad_state >> 4) & 0x0F);
-        }
-        return result;
-    }
-    else if (addr == 0xFF01) {
-        return io.serial_data[0];
+// Watch serial output for the "Passed" line test ROMs print when they finish.
+static void serial_watch(char c) {
+    static const char passed[] = "Passed";
+    static size_t matched = 0;
+
+    if (c == passed[matched]) {
+        matched++;
+    } else {
+        matched = (c == passed[0]) ? 1 : 0;
     }
-    else if (addr == 0xFF02) {
-        return io.serial_data[1];
+    if (matched == sizeof(passed) - 1) {
+        std::printf("\n*** PASSED ***\n");
+        fflush(stdout);
+        matched = 0;
     }
-    else if (addr >= 0xFF04 && addr <= 0xFF07) {
-        return timer_read(addr);
+}
+
+// ---- registers with side effects ----
+
+// Joypad register (P1/JOYP):
+//   Bits 7-6: unused, always 1
+//   Bit 5: 0 = select action buttons (Start/Select/B/A)
+//   Bit 4: 0 = select d-pad (Down/Up/Left/Right)
+//   Bits 3-0: button state (0 = pressed, 1 = not pressed)
+static uint8_t p1_read(uint16_t) {
+    uint8_t result = 0xCF; // all unselected, no buttons
+    if (!(io.joypad & 0x10)) {
+        // D-pad selected: bits 0-3 of joypad_state = Right,Left,Up,Down
+        result = 0xC0 | (io.joypad & 0x30) | (~joypad_state & 0x0F);
     }
-    else if (addr == 0xFF0F) {
-        return io.if_reg;
+    if (!(io.joypad & 0x20)) {
+        // Action buttons selected: bits 4-7 of joypad_state = A,B,Select,Start
+        result = 0xC0 | (io.joypad & 0x30) | (~(joypad_state >> 4) & 0x0F);
     }
-    else if (addr == 0xFF40) {
-        return io.lcdc;
+    return result;
+}
+
+static void p1_write(uint16_t, uint8_t val) {
+    // Only bits 4-5 are writable (button group selection)
+    io.joypad = (io.joypad & 0xCF) | (val & 0x30);
+}
+
+// A transfer on the internal clock shifts 8 bits out at 8192 Hz.
+static constexpr uint32_t SERIAL_TRANSFER_CYCLES = 8 * 512;
+static uint8_t serial_out;  // byte being shifted out
+
+static void sc_write(uint16_t, uint8_t val) {
+    io.serial_data[1] = val;
+    if ((val & 0x81) == 0x81) {
+        serial_out = io.serial_data[0];
+        sched_set(EV_SERIAL, sched.now + SERIAL_TRANSFER_CYCLES);
+    } else {
+        // Stopped, or waiting on an external clock that never comes.
+        sched_set(EV_SERIAL, SCHED_NEVER);
     }
-    else if (addr == 0xFF41) {
-        return io.stat;
+}
+
+void serial_event() {
+    char c = static_cast<char>(serial_out);
+    putchar(c);
+    fflush(stdout);
+    serial_watch(c);
+    io.serial_data[0] = 0xFF;   // nothing on the other end of the link
+    io.serial_data[1] &= 0x7F;  // transfer complete
+    request_interrupt(IT_SERIAL);
+}
+
+static void if_write(uint16_t, uint8_t val) {
+    io.if_reg = val;
+    interrupt_flags_changed();
+}
+
+static void lcdc_write(uint16_t, uint8_t val) {
+    ppu_lcdc_write(val);
+}
+
+// LY and the STAT mode bits are only current once the PPU has caught up.
+static uint8_t stat_read(uint16_t) {
+    ppu_sync();
+    return io.stat | 0x80;
+}
+
+static void stat_write(uint16_t, uint8_t val) {
+    ppu_stat_write(val);
+}
+
+static uint8_t ly_read(uint16_t) {
+    ppu_sync();
+    return io.ly;
+}
+
+static void ly_write(uint16_t, uint8_t) {
+    // LY is read-only
+}
+
+static void lyc_write(uint16_t, uint8_t val) {
+    ppu_lyc_write(val);
+}
+
+// Scroll, window and palette registers: the PPU catches up on the lines
+// drawn with the old value first.
+template <uint8_t io_context::*REG>
+static void ppu_reg_write(uint16_t, uint8_t val) {
+    ppu_sync();
+    io.*REG = val;
+}
+
+static void dma_write(uint16_t, uint8_t val) {
+    io.dma = val;
+    dma_start(val);
+}
+
+// ---- register table ----
+
+// One entry per address in 0xFF00-0xFF7F. Plain registers are a byte slot
+// read back with their unused bits set; registers with side effects have
+// handlers instead. Entries with neither read as 0xFF and ignore writes.
+typedef struct {
+    uint8_t *slot;
+    uint8_t unused;                              // bits that always read as 1
+    uint8_t (*read)(uint16_t addr);
+    void (*write)(uint16_t addr, uint8_t val);
+} io_register;
+
+typedef struct {
+    io_register regs[0x80];
+} io_register_table;
+
+static io_register_table build_register_table() {
+    io_register_table t{};
+    auto plain = [&](uint16_t addr, uint8_t *slot, uint8_t unused) {
+        t.regs[addr & 0x7F].slot = slot;
+        t.regs[addr & 0x7F].unused = unused;
+    };
+
+    t.regs[0x00] = {nullptr, 0, p1_read, p1_write};
+    plain(0xFF01, &io.serial_data[0], 0x00);
+    plain(0xFF02, &io.serial_data[1], 0x7E);
+    t.regs[0x02].write = sc_write;
+    for (uint16_t addr = 0xFF04; addr <= 0xFF07; addr++) {
+        t.regs[addr & 0x7F] = {nullptr, 0, timer_read, timer_write};
     }
-    else if (addr == 0xFF44) {
-        return io.ly;
+    plain(0xFF0F, &io.if_reg, 0xE0);
+    t.regs[0x0F].write = if_write;
+
+    // Sound. NR13, NR23 and NR33 are write-only; FF15 and FF1F do not exist.
+    plain(0xFF10, &io.nr10, 0x80);
+    plain(0xFF11, &io.nr11, 0x3F);
+    plain(0xFF12, &io.nr12, 0x00);
+    plain(0xFF14, &io.nr14, 0xBF);
+    plain(0xFF16, &io.nr21, 0x3F);
+    plain(0xFF17, &io.nr22, 0x00);
+    plain(0xFF19, &io.nr24, 0xBF);
+    plain(0xFF1A, &io.nr30, 0x7F);
+    plain(0xFF1B, &io.nr31, 0xFF);
+    plain(0xFF1C, &io.nr32, 0x9F);
+    plain(0xFF1E, &io.nr34, 0xBF);
+    plain(0xFF20, &io.nr41, 0xFF);
+    plain(0xFF21, &io.nr42, 0x00);
+    plain(0xFF22, &io.nr43, 0x00);
+    plain(0xFF23, &io.nr44, 0xBF);
+    plain(0xFF24, &io.nr50, 0x00);
+    plain(0xFF25, &io.nr51, 0x00);
+    plain(0xFF26, &io.nr52, 0x70);
+    for (uint16_t addr = 0xFF30; addr <= 0xFF3F; addr++) {
+        plain(addr, &io.wave_ram[addr - 0xFF30], 0x00);
     }
-    else if (addr == 0xFF46) {
-        return io.dma;
+
+    // PPU
+    plain(0xFF40, &io.lcdc, 0x00);
+    t.regs[0x40].write = lcdc_write;
+    t.regs[0x41] = {nullptr, 0, stat_read, stat_write};
+    plain(0xFF42, &io.scy, 0x00);
+    t.regs[0x42].write = ppu_reg_write<&io_context::scy>;
+    plain(0xFF43, &io.scx, 0x00);
+    t.regs[0x43].write = ppu_reg_write<&io_context::scx>;
+    t.regs[0x44] = {nullptr, 0, ly_read, ly_write};
+    plain(0xFF45, &io.lyc, 0x00);
+    t.regs[0x45].write = lyc_write;
+    plain(0xFF46, &io.dma, 0x00);
+    t.regs[0x46].write = dma_write;
+    plain(0xFF47, &io.bgp, 0x00);
+    t.regs[0x47].write = ppu_reg_write<&io_context::bgp>;
+    plain(0xFF48, &io.obp0, 0x00);
+    t.regs[0x48].write = ppu_reg_write<&io_context::obp0>;
+    plain(0xFF49, &io.obp1, 0x00);
+    t.regs[0x49].write = ppu_reg_write<&io_context::obp1>;
+    plain(0xFF4A, &io.wy, 0x00);
+    t.regs[0x4A].write = ppu_reg_write<&io_context::wy>;
+    plain(0xFF4B, &io.wx, 0x00);
+    t.regs[0x4B].write = ppu_reg_write<&io_context::wx>;
+    return t;
+}
+
+static const io_register_table io_registers = build_register_table();
+
+uint8_t io_read(uint16_t addr) {
+    const io_register &reg = io_registers.regs[addr & 0x7F];
+    if (reg.slot) {
+        return *reg.slot | reg.unused;
     }
-    // Sound registers
-    else if (addr == 0xFF10) return io.nr10;
-    else if (addr == 0xFF11) return io.nr11;
-    else if (addr == 0xFF12) return io.nr12;
-    else if (addr == 0xFF14) return io.nr14;
-    else if (addr == 0xFF16) return io.nr21;
-    else if (addr == 0xFF17) return io.nr22;
-    else if (addr == 0xFF19) return io.nr24;
-    else if (addr == 0xFF1A) return io.nr30;
-    else if (addr == 0xFF1B) return io.nr31;
-    else if (addr == 0xFF1C) return io.nr32;
-    else if (addr == 0xFF1E) return io.nr34;
-    else if (addr == 0xFF20) return io.nr41;
-    else if (addr == 0xFF21) return io.nr42;
-    else if (addr == 0xFF22) return io.nr43;
-    else if (addr == 0xFF23) return io.nr44;
-    else if (addr == 0xFF24) return io.nr50;
-    else if (addr == 0xFF25) return io.nr51;
-    else if (addr == 0xFF26) return io.nr52;
-    // PPU registers
-    else if (addr == 0xFF42) return io.scy;
-    else if (addr == 0xFF43) return io.scx;
-    else if (addr == 0xFF45) return io.lyc;
-    else if (addr == 0xFF47) return io.bgp;
-    else if (addr == 0xFF48) return io.obp0;
-    else if (addr == 0xFF49) return io.obp1;
-    else if (addr == 0xFF4A) return io.wy;
-    else if (addr == 0xFF4B) return io.wx;
-    return 0xFF;
+    return reg.read ? reg.read(addr) : 0xFF;
 }
 
 void io_write(uint16_t addr, uint8_t val) {
-    if (addr == 0xFF02 && val == 0x81) {
-        char c = io.serial_data[0];          // FF01
-        putchar(c);
-        fflush(stdout);
-        io.serial_data[1] = 0x00;            // transfer complete
-        return;
-    }
-    if (addr == 0xFF00) {
-        // Only bits 4-5 are writable (button group selection)
-        io.joypad = (io.joypad & 0xCF) | (val & 0x30);
-    }
-    else if (addr == 0xFF01) {
-        io.serial_data[0] = val;
-    }
-    else if (addr == 0xFF02) {
-        io.serial_data[1] = val;
-        if (val == 0x81) {
-            std::printf("%c", io.serial_data[0]);
-            fflush(stdout);
-            io.serial_data[1] = 0;
-        }
+    const io_register &reg = io_registers.regs[addr & 0x7F];
+    if (reg.write) {
+        reg.write(addr, val);
+    } else if (reg.slot) {
+        *reg.slot = val;
     }
-    else if (addr >= 0xFF04 && addr <= 0xFF07) {
-        timer_write(addr, val);
-    }
-    else if (addr == 0xFF0F) {
-        io.if_reg = val;
-    }
-    else if (addr == 0xFF40) {
-        io.lcdc = val;
-    }
-    else if (addr == 0xFF41) {
-        // Bits 0-2 are read-only (mode + LYC flag), only bits 3-6 are writable
-        io.stat = (io.stat & 0x07) | (val & 0x78);
-    }
-    else if (addr == 0xFF44) {
-        return;  // LY is read-only
-    }
-    else if (addr == 0xFF46) {
-        io.dma = val;
-        dma_start(val);
-    }
-    // Sound registers
-    else if (addr == 0xFF10) io.nr10 = val;
-    else if (addr == 0xFF11) io.nr11 = val;
-    else if (addr == 0xFF12) io.nr12 = val;
-    else if (addr == 0xFF14) io.nr14 = val;
-    else if (addr == 0xFF16) io.nr21 = val;
-    else if (addr == 0xFF17) io.nr22 = val;
-    else if (addr == 0xFF19) io.nr24 = val;
-    else if (addr == 0xFF1A) io.nr30 = val;
-    else if (addr == 0xFF1B) io.nr31 = val;
-    else if (addr == 0xFF1C) io.nr32 = val;
-    else if (addr == 0xFF1E) io.nr34 = val;
-    else if (addr == 0xFF20) io.nr41 = val;
-    else if (addr == 0xFF21) io.nr42 = val;
-    else if (addr == 0xFF22) io.nr43 = val;
-    else if (addr == 0xFF23) io.nr44 = val;
-    else if (addr == 0xFF24) io.nr50 = val;
-    else if (addr == 0xFF25) io.nr51 = val;
-    else if (addr == 0xFF26) io.nr52 = val;
-    // PPU registers
-    else if (addr == 0xFF42) io.scy = val;
-    else if (addr == 0xFF43) io.scx = val;
-    else if (addr == 0xFF45) io.lyc = val;
-    else if (addr == 0xFF47) io.bgp = val;
-    else if (addr == 0xFF48) io.obp0 = val;
-    else if (addr == 0xFF49) io.obp1 = val;
-    else if (addr == 0xFF4A) io.wy = val;
-    else if (addr == 0xFF4B) io.wx = val;
-}
\ No newline at end of file
+}
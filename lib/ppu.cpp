@@ -1,8 +1,8 @@
 #include "ppu.h"
 #include "io.h"
-#include "bus.h"
 #include "ram.h"
 #include "interrupt.h"
+#include "scheduler.h"
 #include <cstdint>
 #include <vector>
 #include <stdlib.h>
@@ -24,6 +24,8 @@ static int ppu_dots = 0;
 static uint8_t ppu_mode = 2;
 static bool stat_irq_line = false;
 static int window_line = 0;
+static uint64_t ppu_synced = 0;  // sched.now ppu_dots is counted up to
+static uint64_t ppu_next_change = SCHED_NEVER;  // first mode or LY change after ppu_synced
 
 uint32_t screen[SCREEN_WIDTH * SCREEN_HEIGHT];
 
@@ -36,6 +38,67 @@ static void check_lyc();
 static void update_stat_irq();
 static void get_sprites();
 static void render_scanline();
+static void ppu_schedule();
+
+// The PPU has its own path to VRAM and OAM, so it reads them directly
+// instead of through the CPU bus (which OAM DMA locks).
+static inline uint8_t oam_byte(uint16_t addr) {
+    return ram.oam[addr - 0xFE00];
+}
+
+// Decoded tile data: the 384 tiles at 0x8000-0x97FF as one color index per
+// pixel, unflipped and mirrored (for X-flipped sprites). A tile is decoded
+// again the first time it is drawn after a VRAM write to it.
+static const int TILE_COUNT = 384;
+static uint8_t tile_pixels[2][TILE_COUNT][8][8];
+static bool tile_dirty[TILE_COUNT];
+
+void ppu_vram_written(uint16_t index, uint16_t count) {
+    uint32_t end = std::min<uint32_t>(index + count, TILE_COUNT * 16);
+    for (uint32_t tile = index / 16u; tile * 16 < end; tile++) {
+        tile_dirty[tile] = true;
+    }
+}
+
+static void decode_tile(int tile) {
+    const uint8_t *data = &ram.vram[0][tile * 16];
+    for (int row = 0; row < 8; row++) {
+        uint8_t lo = data[row * 2];
+        uint8_t hi = data[row * 2 + 1];
+        for (int x = 0; x < 8; x++) {
+            int bit = 7 - x;
+            uint8_t color_index = (((hi >> bit) & 1) << 1) | ((lo >> bit) & 1);
+            tile_pixels[0][tile][row][x] = color_index;
+            tile_pixels[1][tile][row][7 - x] = color_index;
+        }
+    }
+    tile_dirty[tile] = false;
+}
+
+// 8 color indexes of one row of `tile`, mirrored if `flip_x`.
+static inline const uint8_t *tile_row(int tile, int row, bool flip_x = false) {
+    if (tile_dirty[tile]) {
+        decode_tile(tile);
+    }
+    return tile_pixels[flip_x][tile][row];
+}
+
+// Tile number of a background/window tile id under LCDC bit 4: 0x8000
+// unsigned, or 0x9000 signed.
+static inline int bg_tile(uint8_t tile_id, uint8_t addr_mode) {
+    return addr_mode == 1 ? tile_id : 256 + static_cast<int8_t>(tile_id);
+}
+
+// Pixel row `row` of `tiles` consecutive map tiles from column `col` of
+// `map_row`, as color indexes into `out`. The background wraps at 32
+// columns, the window never reaches the end of the map.
+static void fetch_map_row(const uint8_t *map_row, int col, int row, int tiles,
+                          uint8_t addr_mode, bool wrap, uint8_t *out) {
+    for (int t = 0; t < tiles; t++) {
+        int c = wrap ? (col + t) & 31 : col + t;
+        std::copy_n(tile_row(bg_tile(map_row[c], addr_mode), row), 8, out + t * 8);
+    }
+}
 
 static uint32_t palette_lookup(uint8_t palette, uint8_t color_index) {
     uint8_t shade = (palette >> (color_index * 2)) & 0x03;
@@ -49,9 +112,11 @@ void ppu_init() {
     window_line = 0;
     io.ly = 0;
     std::fill(std::begin(screen), std::end(screen), dmg_colors[0]);
+    ppu_synced = sched.now;
+    ppu_schedule();
 }
 
-void ppu_step(uint8_t cycles) {
+static void ppu_step(uint32_t cycles) {
 
     // do a power check to see if the gameboy is powered on
     if (!(io.lcdc & 0x80)) {
@@ -124,6 +189,95 @@ void ppu_step(uint8_t cycles) {
     }
 }
 
+// From the line ppu_step was last brought up to, work out when its next mode
+// or LY change is due and schedule EV_PPU for the first one that can request
+// an interrupt. Everything in between is caught up when it is observed.
+static void ppu_schedule() {
+    if (!(io.lcdc & 0x80)) {
+        ppu_next_change = SCHED_NEVER;
+        sched_set(EV_PPU, SCHED_NEVER);
+        return;
+    }
+
+    uint64_t line = ppu_synced - static_cast<uint64_t>(ppu_dots);
+    uint64_t next_line = line + 456;
+    bool visible = io.ly < 144;
+    bool drawing = ppu_mode == 2 || ppu_mode == 3;
+
+    ppu_next_change = ppu_mode == 2 ? line + 80 : ppu_mode == 3 ? line + 252 : next_line;
+
+    // VBlank starts at line 144; OAM scan (mode 2) at lines 0-143 and HBlank
+    // (mode 0) 252 dots into them.
+    uint64_t vblank = next_line + (visible ? 143 - io.ly : 153 - io.ly + 144) * 456ull;
+    uint64_t oam_scan = io.ly < 143 ? next_line
+                      : visible     ? vblank + 10 * 456
+                                    : next_line + (153 - io.ly) * 456ull;
+    uint64_t hblank = drawing ? line + 252 : oam_scan + 252;
+
+    // Wake only where ppu_step can request an interrupt: VBlank (which is
+    // also the mode 1 STAT source) and the enabled STAT sources.
+    uint64_t when = vblank;
+    if (io.stat & 0x20) when = std::min<uint64_t>(when, oam_scan);
+    if (io.stat & 0x08) when = std::min<uint64_t>(when, hblank);
+    if ((io.stat & 0x40) && io.lyc <= 153) {
+        uint32_t lines = (io.lyc + 154 - io.ly - 1) % 154;  // line ends until LY == LYC
+        when = std::min<uint64_t>(when, next_line + lines * 456ull);
+    }
+    sched_set(EV_PPU, when);
+}
+
+void ppu_sync_to(uint64_t when) {
+    if (when < ppu_next_change) {
+        return;
+    }
+    ppu_step(static_cast<uint32_t>(when - ppu_synced));
+    ppu_synced = when;
+    ppu_schedule();
+}
+
+void ppu_sync() {
+    ppu_sync_to(sched.now);
+}
+
+void ppu_event() {
+    ppu_step(static_cast<uint32_t>(sched.now - ppu_synced));
+    ppu_synced = sched.now;
+    ppu_schedule();
+}
+
+uint32_t ppu_cycles_to_next_change(uint32_t limit) {
+    ppu_sync();
+    uint64_t cycles = ppu_next_change - sched.now;
+    return cycles < limit ? static_cast<uint32_t>(cycles) : limit;
+}
+
+void ppu_lcdc_write(uint8_t value) {
+    ppu_sync();
+    bool was_on = (io.lcdc & 0x80) != 0;
+    io.lcdc = value;
+    if (was_on == ((value & 0x80) != 0)) {
+        return;
+    }
+    // Turning the LCD off resets the PPU; turning it on starts counting dots
+    // from the cycles of the writing instruction.
+    ppu_step(0);
+    ppu_synced = sched.now;
+    ppu_schedule();
+}
+
+void ppu_stat_write(uint8_t value) {
+    ppu_sync();
+    // Bits 0-2 are read-only (mode + LYC flag), only bits 3-6 are writable
+    io.stat = (io.stat & 0x07) | (value & 0x78);
+    ppu_schedule();
+}
+
+void ppu_lyc_write(uint8_t value) {
+    ppu_sync();
+    io.lyc = value;
+    ppu_schedule();
+}
+
 void ppu_oam_write(uint16_t address, uint8_t value) {
     extern Ram ram;
     if (address >= 0xFE00) {
@@ -168,10 +322,10 @@ static void get_sprites() {
     for (int i = 0; i < 40; i++) {
         uint16_t addr = 0xFE00 + i * 0x4;
         int sprite_height = (io.lcdc & 0x04) ? 16 : 8;
-        int y = static_cast<int>(bus_read(addr)) - 16;
-        int x = static_cast<int>(bus_read(addr + 0x1)) - 8;
-        uint8_t tile_id = bus_read(addr + 0x2);
-        uint8_t attribute_flags = bus_read(addr + 0x3);
+        int y = static_cast<int>(oam_byte(addr)) - 16;
+        int x = static_cast<int>(oam_byte(addr + 0x1)) - 8;
+        uint8_t tile_id = oam_byte(addr + 0x2);
+        uint8_t attribute_flags = oam_byte(addr + 0x3);
 
         if (io.ly >= y && io.ly < y + sprite_height) {
             sprites[found] = Sprite{x, y, tile_id, attribute_flags};
@@ -192,43 +346,30 @@ static void render_scanline() {
     uint8_t bg_tile_map = (io.lcdc >> 3) & 1;
 
     uint16_t base_addr = (bg_tile_map == 1) ? 0x9C00 : 0x9800;
-    uint16_t tile_addr;
+    uint32_t *line = &screen[io.ly * SCREEN_WIDTH];
+
+    uint32_t bg_colors[4];
+    for (uint8_t c = 0; c < 4; c++) {
+        bg_colors[c] = palette_lookup(io.bgp, c);
+    }
 
     uint8_t bg_scanline[SCREEN_WIDTH];
     for (int i = 0; i < SCREEN_WIDTH; i++) {
         bg_scanline[i] = 0;
     }
 
-    // background
+    // background: the 21 tiles the line overlaps, then the 160 pixels
+    // starting SCX % 8 into the first one
     if (io.lcdc & 0x01) {
-        for (int i = 0; i < SCREEN_WIDTH; i++) {
-            int bg_x = (io.scx + i) & 0xFF;
-            int bg_y = (io.scy + io.ly) & 0xFF;
-
-            int tile_col = bg_x / 8;
-            int tile_row = bg_y / 8;
+        int bg_y = (io.scy + io.ly) & 0xFF;
+        const uint8_t *map_row = &ram.vram[0][base_addr - 0x8000 + (bg_y / 8) * 32];
+        uint8_t pixels[SCREEN_WIDTH + 8];
+        fetch_map_row(map_row, io.scx / 8, bg_y % 8, SCREEN_WIDTH / 8 + 1, addr_mode, true, pixels);
 
-            uint8_t tile_id = bus_read(base_addr + tile_row * 32 + tile_col);
-
-            if (addr_mode == 1) {
-                tile_addr = 0x8000 + tile_id * 16;
-            } else {
-                int8_t offset = static_cast<int8_t>(tile_id);
-                tile_addr = 0x9000 + offset * 16;
-            }
-
-            int in_x = bg_x % 8;
-            int in_y = bg_y % 8;
-
-            uint16_t row_addr = tile_addr + 2 * in_y;
-            uint8_t lo = bus_read(row_addr);
-            uint8_t hi = bus_read(row_addr + 1);
-
-            int bit = 7 - in_x;
-            uint8_t color_index = (((hi >> bit) & 1) << 1) | ((lo >> bit) & 1);
-
-            screen[io.ly * SCREEN_WIDTH + i] = palette_lookup(io.bgp, color_index);
-            bg_scanline[i] = color_index;
+        const uint8_t *from = pixels + io.scx % 8;
+        for (int i = 0; i < SCREEN_WIDTH; i++) {
+            line[i] = bg_colors[from[i]];
+            bg_scanline[i] = from[i];
         }
     }
 
@@ -236,42 +377,20 @@ static void render_scanline() {
     if ((io.lcdc & 0x20) && io.ly >= io.wy) {
         int wx_start = io.wx - 7;
         uint16_t win_base = (io.lcdc & 0x40) ? 0x9C00 : 0x9800;
-        bool window_visible = false;
-
-        for (int i = 0; i < SCREEN_WIDTH; i++) {
-            if (i < wx_start) continue;
-            window_visible = true;
-
-            int win_x = i - wx_start;
-            int win_y = window_line;
 
-            int tile_col = win_x / 8;
-            int tile_row = win_y / 8;
-
-            uint8_t tile_id = bus_read(win_base + tile_row * 32 + tile_col);
-
-            if (addr_mode == 1) {
-                tile_addr = 0x8000 + tile_id * 16;
-            } else {
-                int8_t offset = static_cast<int8_t>(tile_id);
-                tile_addr = 0x9000 + offset * 16;
+        if (wx_start < SCREEN_WIDTH) {
+            int first = std::max(wx_start, 0);
+            int win_x = first - wx_start;
+            const uint8_t *map_row = &ram.vram[0][win_base - 0x8000 + (window_line / 8) * 32];
+            uint8_t pixels[SCREEN_WIDTH + 8];
+            int tiles = (win_x % 8 + SCREEN_WIDTH - first + 7) / 8;
+            fetch_map_row(map_row, win_x / 8, window_line % 8, tiles, addr_mode, false, pixels);
+
+            const uint8_t *from = pixels + win_x % 8;
+            for (int i = first; i < SCREEN_WIDTH; i++) {
+                line[i] = bg_colors[from[i - first]];
+                bg_scanline[i] = from[i - first];
             }
-
-            int in_x = win_x % 8;
-            int in_y = win_y % 8;
-
-            uint16_t row_addr = tile_addr + 2 * in_y;
-            uint8_t lo = bus_read(row_addr);
-            uint8_t hi = bus_read(row_addr + 1);
-
-            int bit = 7 - in_x;
-            uint8_t color_index = (((hi >> bit) & 1) << 1) | ((lo >> bit) & 1);
-
-            screen[io.ly * SCREEN_WIDTH + i] = palette_lookup(io.bgp, color_index);
-            bg_scanline[i] = color_index;
-        }
-
-        if (window_visible) {
             window_line++;
         }
     }
@@ -313,18 +432,10 @@ static void render_scanline() {
                 }
             }
 
-            uint16_t sprite_row_addr = 0x8000 + tile * 16 + row_in_tile * 2;
-            uint8_t lo = bus_read(sprite_row_addr);
-            uint8_t hi = bus_read(sprite_row_addr + 1);
+            const uint8_t *pixels = tile_row(tile, row_in_tile, flip_x);
 
             for (int j = 0; j < 8; j++) {
-                int bit = 7 - j;
-
-                if (flip_x) {
-                    bit = 7 - bit;
-                }
-
-                uint8_t color_index = (((hi >> bit) & 1) << 1) | ((lo >> bit) & 1);
+                uint8_t color_index = pixels[j];
                 if (color_index == 0) {
                     continue;
                 }
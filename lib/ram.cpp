@@ -1,15 +1,19 @@
 #include "ram.h"
+#include "interrupt.h"
+#include "ppu.h"
 #include <cstring>
 
 Ram ram;
 
 void ram_init() {
     memset(ram.vram, 0, sizeof(ram.vram));
+    ppu_vram_written(0, sizeof(ram.vram[0]));
     memset(ram.wram, 0, sizeof(ram.wram));
     memset(ram.oam, 0, sizeof(ram.oam));
     memset(ram.hram, 0, sizeof(ram.hram));
     
     ram.ie = 0x00;
+    interrupt_flags_changed();
 }
 
 uint8_t vram_read(uint16_t index) {
@@ -18,6 +22,7 @@ uint8_t vram_read(uint16_t index) {
 
 void vram_write(uint16_t index, uint8_t val) {
     ram.vram[0][index] = val;
+    ppu_vram_written(index, 1);
 }
 
 uint8_t wram_read(uint16_t index) {
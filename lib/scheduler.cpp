@@ -0,0 +1,50 @@
+#include "scheduler.h"
+#include "timer.h"
+#include "dma.h"
+#include "ppu.h"
+#include "io.h"
+#include <cstdint>
+
+scheduler sched = {0, SCHED_NEVER, {SCHED_NEVER, SCHED_NEVER, SCHED_NEVER, SCHED_NEVER}};
+
+// Indexed by sched_event. Timer and DMA run before the PPU, as they did when
+// each step ticked them first.
+static void (*const handlers[EV_COUNT])() = {
+    timer_event,
+    dma_event,
+    ppu_event,
+    serial_event,
+};
+
+static void sched_update_next() {
+    uint64_t next = SCHED_NEVER;
+    for (uint64_t at : sched.at) {
+        if (at < next) {
+            next = at;
+        }
+    }
+    sched.next = next;
+}
+
+void sched_init() {
+    sched.now = 0;
+    for (uint64_t &at : sched.at) {
+        at = SCHED_NEVER;
+    }
+    sched.next = SCHED_NEVER;
+}
+
+void sched_set(sched_event ev, uint64_t when) {
+    sched.at[ev] = when;
+    sched_update_next();
+}
+
+void sched_dispatch() {
+    for (int ev = 0; ev < EV_COUNT; ev++) {
+        if (sched.at[ev] <= sched.now) {
+            sched.at[ev] = SCHED_NEVER;
+            handlers[ev]();
+        }
+    }
+    sched_update_next();
+}
@@ -1,34 +1,71 @@
 #include "timer.h"
 #include "interrupt.h"
+#include "scheduler.h"
+#include <cstdint>
 
 timer_ctx timer;
 
-void timer_init() {
-    timer.counter = 0xABCC; 
-    timer.tima = 0x00;
-    timer.tma = 0x00;
-    timer.tac = 0x00; 
-    timer.prev_and_result = false;
-    timer.interrupt_pending = false;
+static uint32_t timer_cycles_to_overflow();
+
+// The divider counter, unwrapped: it counts T-cycles since it was last reset
+// and its low 16 bits are the hardware counter.
+static uint64_t timer_counter(uint64_t at) {
+    return at - timer.div_base;
 }
 
-void timer_tick() {
-    timer.counter+= 1;
+// TIMA steps on the falling edge of the selected counter bit, i.e. each time
+// the counter reaches a multiple of twice that bit.
+static uint32_t timer_period() {
+    return 2u * get_system_bit_mask(timer.tac);
+}
 
-    bool current_signal = (timer.tac & 0x04) != 0;
+// The AND of the enable bit and the selected counter bit, whose falling
+// edges step TIMA.
+static bool timer_signal() {
+    return (timer.tac & 0x04) && (timer_counter(sched.now) & get_system_bit_mask(timer.tac));
+}
 
-    if (current_signal) {
-        current_signal = (timer.counter & get_system_bit_mask(timer.tac)) != 0;
+// Apply the TIMA steps between timer.synced and now.
+static void timer_sync() {
+    if (timer.tac & 0x04) {
+        uint32_t period = timer_period();
+        uint64_t steps = timer_counter(sched.now) / period - timer_counter(timer.synced) / period;
+        while (steps) {
+            uint64_t to_overflow = 0x100u - timer.tima;
+            if (steps < to_overflow) {
+                timer.tima = static_cast<uint8_t>(timer.tima + steps);
+                break;
+            }
+            steps -= to_overflow;
+            timer.tima = 0xFF;
+            tima_increment();
+        }
     }
+    timer.synced = sched.now;
+}
 
-    if (timer.prev_and_result && !current_signal) {
-        tima_increment();
-    }
+static void timer_schedule() {
+    uint32_t cycles = timer_cycles_to_overflow();
+    sched_set(EV_TIMER, cycles == UINT32_MAX ? SCHED_NEVER : sched.now + cycles);
+}
+
+void timer_init() {
+    timer.div_base = sched.now - 0xABCC;
+    timer.synced = sched.now;
+    timer.tima = 0x00;
+    timer.tma = 0x00;
+    timer.tac = 0x00; 
+    timer.interrupt_pending = false;
+    timer_schedule();
+}
 
-    timer.prev_and_result = current_signal;
+void timer_event() {
+    timer_sync();
+    timer_schedule();
 }
 
 uint8_t timer_read(uint16_t address) {
+    timer_sync();
     switch (address) {
         case 0xFF04:
             return get_div();
@@ -43,6 +80,7 @@ uint8_t timer_read(uint16_t address) {
 }
 
 void timer_write(uint16_t address, uint8_t value) {
+    timer_sync();
     switch (address) {
         case 0xFF04:
             timer_write_div();
@@ -57,6 +95,7 @@ void timer_write(uint16_t address, uint8_t value) {
             timer_write_tac(value);
             break;
     }
+    timer_schedule();
 }
 
 uint16_t get_system_bit_mask(uint8_t tac) {
@@ -79,32 +118,42 @@ void tima_increment() {
     }
 }
 
+// Changing TAC can drop the signal from 1 to 0, which counts as an edge.
 void timer_write_tac(uint8_t value) {
-    bool old_signal = timer.prev_and_result;
-    
+    timer_sync();
+    bool old_signal = timer_signal();
     timer.tac = value;
-
-    bool enable = (timer.tac & 0x04) != 0;
-    bool bit_state = (timer.counter & get_system_bit_mask(timer.tac)) != 0;
-    bool current_signal = enable && bit_state;
-    
-    timer.prev_and_result = current_signal;
-
-    if (old_signal && !current_signal) {
+    if (old_signal && !timer_signal()) {
         tima_increment();
     }
+    timer_schedule();
 }
 
+// So can resetting the counter. Also used by STOP, so it syncs and
+// reschedules itself.
 void timer_write_div() {
-    bool old_signal = timer.prev_and_result;
-    timer.counter = 0;
-    timer.prev_and_result = false;
+    timer_sync();
+    bool old_signal = timer_signal();
+    timer.div_base = sched.now;
 
     if (old_signal) {
         tima_increment();
     }
+    timer_schedule();
+}
+
+// T-cycles until the tick on which TIMA overflows and requests the timer
+// interrupt; UINT32_MAX while the timer is stopped. Expects a synced timer.
+static uint32_t timer_cycles_to_overflow() {
+    if (!(timer.tac & 0x04)) {
+        return UINT32_MAX;
+    }
+
+    uint32_t period = timer_period();
+    uint32_t first = period - (timer_counter(sched.now) & (period - 1));
+    return first + (0xFFu - timer.tima) * period;
 }
 
 uint8_t get_div() {
-    return (timer.counter >> 8) & 0xFF;
-}
\ No newline at end of file
+    return (timer_counter(sched.now) >> 8) & 0xFF;
+}
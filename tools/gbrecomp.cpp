@@ -0,0 +1,305 @@
+// gbrecomp - ahead-of-time recompiler: turns a ROM into a C++ module of
+// per-block functions for cpu_aot_load() (see include/cpu_aot.h).
+//
+//   gbrecomp <rom> <out.cpp>
+//
+// Control flow is followed from the entry point, the RST vectors and the
+// interrupt vectors. Code in the switchable bank is compiled for the bank
+// the walk believes is mapped: `LD A,n` followed by `LD (2000-3FFF),A`
+// switches it, everything else keeps the bank it came in with. A wrong guess
+// only costs coverage, never correctness: blocks are looked up by the bank
+// actually mapped at run time and anything not compiled is interpreted.
+
+#include "cpu_instructions.h"
+#include "cpu_dispatch.h"
+#include "block_cache.h"
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+typedef struct {
+    uint16_t pc;
+    uint16_t op;          // dispatch_table index (CB opcodes at CB_OPCODE_BASE)
+    uint8_t length;
+    uint8_t bytes[3];
+} recomp_instr;
+
+typedef struct {
+    uint16_t bank;
+    uint16_t pc;
+    std::vector<recomp_instr> instrs;
+} recomp_block;
+
+enum class mbc_kind { NONE, MBC1, MBC3, MBC5 };
+
+static std::vector<uint8_t> rom;
+static uint16_t num_banks;
+static mbc_kind mbc;
+
+static uint8_t rom_byte(uint16_t bank, uint32_t addr) {
+    uint32_t offset = addr < 0x4000 ? addr : bank * 0x4000u + (addr - 0x4000);
+    return offset < rom.size() ? rom[offset] : 0xFF;
+}
+
+static mbc_kind mbc_for_type(uint8_t type) {
+    if (type >= 0x01 && type <= 0x03) return mbc_kind::MBC1;
+    if (type >= 0x0F && type <= 0x13) return mbc_kind::MBC3;
+    if (type >= 0x19 && type <= 0x1E) return mbc_kind::MBC5;
+    return mbc_kind::NONE;
+}
+
+// Bank selected by writing `value` to `addr`, or -1 if the write does not
+// select a ROM bank on this cart.
+static int bank_write(uint16_t addr, uint8_t value) {
+    int bank;
+    switch (mbc) {
+        case mbc_kind::MBC1:
+            if (addr < 0x2000 || addr >= 0x4000) return -1;
+            bank = (value & 0x1F) ? (value & 0x1F) : 1;
+            break;
+        case mbc_kind::MBC3:
+            if (addr < 0x2000 || addr >= 0x4000) return -1;
+            bank = (value & 0x7F) ? (value & 0x7F) : 1;
+            break;
+        case mbc_kind::MBC5:
+            if (addr < 0x2000 || addr >= 0x3000) return -1;
+            bank = value;
+            break;
+        default:
+            return -1;
+    }
+    return bank & (num_banks - 1);
+}
+
+// Same block boundaries as the block cache.
+static bool ends_block(const Instruction &inst) {
+    switch (inst.type) {
+        case in_type::IN_JP:
+        case in_type::IN_JR:
+        case in_type::IN_RET:
+            return inst.cond == cond_type::CT_NONE;
+        case in_type::IN_RETI:
+        case in_type::IN_RST:
+        case in_type::IN_HALT:
+        case in_type::IN_STOP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Static targets of a control-flow instruction, including the return
+// address of CALL/RST (the interpreter resumes there after the RET).
+static void branch_targets(const recomp_instr &in, std::vector<uint16_t> &out) {
+    uint16_t next = static_cast<uint16_t>(in.pc + in.length);
+    uint8_t op = in.bytes[0];
+    uint16_t abs = static_cast<uint16_t>(in.bytes[1] | (in.bytes[2] << 8));
+
+    if (op == 0xC3 || op == 0xC2 || op == 0xCA || op == 0xD2 || op == 0xDA) {
+        out.push_back(abs);
+    } else if (op == 0x18 || op == 0x20 || op == 0x28 || op == 0x30 || op == 0x38) {
+        out.push_back(static_cast<uint16_t>(next + static_cast<int8_t>(in.bytes[1])));
+    } else if (op == 0xCD || op == 0xC4 || op == 0xCC || op == 0xD4 || op == 0xDC) {
+        out.push_back(abs);
+        out.push_back(next);
+    } else if ((op & 0xC7) == 0xC7) {
+        out.push_back(op & 0x38);
+        out.push_back(next);
+    } else if (op == 0x76) {
+        out.push_back(next);
+    }
+}
+
+// Decode the block at pc with `hi_bank` mapped at 0x4000-0x7FFF. Returns the
+// bank the walk believes is mapped when the block ends.
+static uint16_t build_block(recomp_block &block, uint16_t pc, uint16_t hi_bank,
+                            std::vector<uint16_t> &successors) {
+    block.pc = pc;
+    block.bank = pc < 0x4000 ? 0 : hi_bank;
+
+    uint32_t end = pc < 0x4000 ? 0x4000 : 0x8000;
+    uint32_t addr = pc;
+    int loaded_a = -1;
+    bool stopped = false;
+
+    while (block.instrs.size() < BLOCK_MAX_INSTRS && addr < end) {
+        recomp_instr in{};
+        in.pc = static_cast<uint16_t>(addr);
+        in.bytes[0] = rom_byte(block.bank, addr);
+
+        Instruction inst;
+        if (in.bytes[0] == 0xCB) {
+            if (addr + 1 >= end) break;
+            in.bytes[1] = rom_byte(block.bank, addr + 1);
+            in.op = CB_OPCODE_BASE | in.bytes[1];
+            inst = decode(in.bytes[1], true);
+            in.length = instruction_length(inst, true);
+        } else {
+            in.op = in.bytes[0];
+            inst = decode(in.bytes[0]);
+            in.length = instruction_length(inst);
+        }
+        if (addr + in.length > end) break;
+
+        for (uint8_t i = 1; i < in.length; i++) {
+            in.bytes[i] = rom_byte(block.bank, addr + i);
+        }
+        block.instrs.push_back(in);
+        addr += in.length;
+        branch_targets(in, successors);
+
+        if (ends_block(inst)) {
+            stopped = true;
+            break;
+        }
+
+        // LD A,n ; LD (nn),A into the MBC bank register
+        if (in.bytes[0] == 0xEA && loaded_a >= 0) {
+            int bank = bank_write(static_cast<uint16_t>(in.bytes[1] | (in.bytes[2] << 8)),
+                                  static_cast<uint8_t>(loaded_a));
+            if (bank >= 0) {
+                hi_bank = static_cast<uint16_t>(bank);
+                // The mapping under a switchable-bank block just changed.
+                if (block.bank != 0) break;
+            }
+        }
+        loaded_a = in.bytes[0] == 0x3E ? in.bytes[1] : -1;
+    }
+
+    if (!stopped && addr < 0x8000) {
+        successors.push_back(static_cast<uint16_t>(addr));
+    }
+    return hi_bank;
+}
+
+static void emit_block(FILE *out, const recomp_block &block) {
+    fprintf(out, "static uint32_t block_%04X_%04X(uint32_t budget) {\n", block.bank, block.pc);
+
+    std::vector<uint8_t> imm;
+    for (const recomp_instr &in : block.instrs) {
+        uint8_t prefix = in.bytes[0] == 0xCB ? 2 : 1;
+        for (uint8_t i = prefix; i < in.length; i++) {
+            imm.push_back(in.bytes[i]);
+        }
+    }
+    if (!imm.empty()) {
+        fprintf(out, "    static const uint8_t imm[] = {");
+        for (size_t i = 0; i < imm.size(); i++) {
+            fprintf(out, "%s0x%02X", i ? ", " : "", imm[i]);
+        }
+        fprintf(out, "};\n");
+    }
+    fprintf(out, "    uint32_t elapsed = 0;\n");
+    fprintf(out, "    uint32_t epoch = block_cache_epoch;\n");
+
+    size_t offset = 0;
+    for (const recomp_instr &in : block.instrs) {
+        uint8_t prefix = in.bytes[0] == 0xCB ? 2 : 1;
+        char imm_ref[32] = "nullptr";
+        if (in.length > prefix) {
+            snprintf(imm_ref, sizeof(imm_ref), "&imm[%zu]", offset);
+            offset += in.length - prefix;
+        }
+        fprintf(out, "    AOT_INSTR(0x%04X, 0x%04X, %u, 0x%03X, %s);\n",
+                in.pc, static_cast<uint16_t>(in.pc + in.length), prefix, in.op, imm_ref);
+    }
+    fprintf(out, "    return elapsed;\n}\n\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        printf("Usage: %s <rom> <out.cpp>\n", argv[0]);
+        return 1;
+    }
+
+    FILE *fp = fopen(argv[1], "rb");
+    if (!fp) {
+        printf("Failed to open: %s\n", argv[1]);
+        return 1;
+    }
+    fseek(fp, 0, SEEK_END);
+    rom.resize(ftell(fp));
+    rewind(fp);
+    size_t read = fread(rom.data(), 1, rom.size(), fp);
+    fclose(fp);
+    if (read != rom.size() || rom.size() < 0x150) {
+        printf("Failed to read ROM: %s\n", argv[1]);
+        return 1;
+    }
+
+    uint8_t type = rom[0x147];
+    uint8_t rom_size = rom[0x148];
+    uint8_t checksum = rom[0x14D];
+    num_banks = static_cast<uint16_t>(2 << rom_size);
+    mbc = mbc_for_type(type);
+
+    // Walk (pc, bank mapped at 0x4000) pairs; blocks are keyed by the bank
+    // their own pc is in, so bank 0 code is only emitted once.
+    std::vector<std::pair<uint16_t, uint16_t>> work;
+    std::set<std::pair<uint16_t, uint16_t>> seen;
+    std::map<std::pair<uint16_t, uint16_t>, recomp_block> blocks;
+
+    auto push = [&](uint16_t pc, uint16_t hi_bank) {
+        if (pc >= 0x8000) return;
+        if (seen.insert({pc, hi_bank}).second) {
+            work.push_back({pc, hi_bank});
+        }
+    };
+
+    push(0x0100, 1);
+    for (uint16_t vector = 0x00; vector <= 0x38; vector += 8) push(vector, 1);
+    for (uint16_t vector = 0x40; vector <= 0x60; vector += 8) push(vector, 1);
+
+    size_t instr_count = 0;
+    while (!work.empty()) {
+        auto [pc, hi_bank] = work.back();
+        work.pop_back();
+
+        recomp_block block;
+        std::vector<uint16_t> successors;
+        uint16_t next_bank = build_block(block, pc, hi_bank, successors);
+        for (uint16_t target : successors) {
+            push(target, next_bank);
+        }
+
+        if (block.instrs.empty()) continue;
+        auto key = std::make_pair(block.bank, block.pc);
+        if (!blocks.count(key)) {
+            instr_count += block.instrs.size();
+            blocks.emplace(key, std::move(block));
+        }
+    }
+
+    FILE *out = fopen(argv[2], "w");
+    if (!out) {
+        printf("Failed to open: %s\n", argv[2]);
+        return 1;
+    }
+
+    fprintf(out, "// Generated by gbrecomp from %s. Do not edit.\n", argv[1]);
+    fprintf(out, "#include \"cpu_aot.h\"\n#include \"cpu_specialized.h\"\n\n");
+    for (const auto &entry : blocks) {
+        emit_block(out, entry.second);
+    }
+
+    fprintf(out, "static const aot_block blocks[] = {\n");
+    for (const auto &entry : blocks) {
+        fprintf(out, "    {0x%04X, 0x%04X, block_%04X_%04X},\n",
+                entry.first.first, entry.first.second, entry.first.first, entry.first.second);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "extern \"C\" const aot_module gb_aot_module = {\n    AOT_MODULE_VERSION,\n    aot_build_fingerprint(),\n    {");
+    for (int i = 0; i < 15; i++) {
+        fprintf(out, "%s0x%02X", i ? ", " : "", rom[0x134 + i]);
+    }
+    fprintf(out, "},\n    0x%02X, 0x%02X, 0x%02X,\n    %zu, blocks\n};\n", type, rom_size, checksum, blocks.size());
+    fclose(out);
+
+    printf("%s: %zu blocks, %zu instructions\n", argv[2], blocks.size(), instr_count);
+    return 0;
+}
@@ -0,0 +1,49 @@
+// trace2txt - convert a binary trace from `make TRACE=1` into the text
+// format of the old cpu_log.txt (one line per instruction).
+//
+//   trace2txt <trace.bin> [out.txt]
+
+#include "cpu_trace.h"
+#include <cstdio>
+#include <cstring>
+
+int main(int argc, char **argv) {
+    if (argc != 2 && argc != 3) {
+        printf("Usage: %s <trace.bin> [out.txt]\n", argv[0]);
+        return 1;
+    }
+
+    FILE *in = fopen(argv[1], "rb");
+    if (!in) {
+        printf("Failed to open: %s\n", argv[1]);
+        return 1;
+    }
+
+    char magic[sizeof(TRACE_MAGIC)];
+    if (fread(magic, 1, sizeof(magic), in) != sizeof(magic) ||
+        memcmp(magic, TRACE_MAGIC, sizeof(magic)) != 0) {
+        printf("Not a trace file: %s\n", argv[1]);
+        fclose(in);
+        return 1;
+    }
+
+    FILE *out = argc == 3 ? fopen(argv[2], "w") : stdout;
+    if (!out) {
+        printf("Failed to open: %s\n", argv[2]);
+        fclose(in);
+        return 1;
+    }
+
+    trace_record rec;
+    while (fread(&rec, sizeof(rec), 1, in) == 1) {
+        fprintf(out, "A:%02X F:%02X B:%02X C:%02X D:%02X E:%02X H:%02X L:%02X SP:%04X PC:%04X PCMEM:%02X,%02X,%02X,%02X\n",
+                rec.A, rec.F, rec.B, rec.C, rec.D, rec.E, rec.H, rec.L, rec.SP, rec.PC,
+                rec.pcmem[0], rec.pcmem[1], rec.pcmem[2], rec.pcmem[3]);
+    }
+
+    fclose(in);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}